@@ -65,6 +65,12 @@ enet_range_coder_destroy (void * context)
     enet_free (rangeCoder);
 }
 
+void *
+enet_range_coder_duplicate (void * context)
+{
+    return enet_range_coder_create ();
+}
+
 #define ENET_SYMBOL_CREATE(symbol, value_, count_) \
 { \
     symbol = & rangeCoder -> symbols [nextSymbol ++]; \
@@ -645,6 +651,7 @@ enet_host_compress_with_range_coder (ENetHost * host)
     compressor.compress = enet_range_coder_compress;
     compressor.decompress = enet_range_coder_decompress;
     compressor.destroy = enet_range_coder_destroy;
+    compressor.duplicate = enet_range_coder_duplicate;
     enet_host_compress (host, & compressor);
     return 0;
 }
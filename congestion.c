@@ -0,0 +1,331 @@
+/**
+ @file  congestion.c
+ @brief ENet built-in congestion controllers
+*/
+#define ENET_BUILDING_LIB 1
+#include <string.h>
+#include "enet/utility.h"
+#include "enet/time.h"
+#include "enet/enet.h"
+
+/** @defgroup congestion ENet built-in congestion controllers
+    @{
+*/
+
+#define ENET_CONGESTION_INITIAL_WINDOW(peer) (10.0 * (peer) -> mtu)
+#define ENET_CONGESTION_MINIMUM_WINDOW(peer) (4.0 * (peer) -> mtu)
+
+static double
+enet_congestion_clamp_window (ENetPeer * peer, double window)
+{
+    if (window < ENET_CONGESTION_MINIMUM_WINDOW (peer))
+      window = ENET_CONGESTION_MINIMUM_WINDOW (peer);
+    else
+    if (window > ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE)
+      window = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+
+    peer -> congestionWindow = (enet_uint32) window;
+
+    return window;
+}
+
+static void ENET_CALLBACK
+enet_congestion_disconnect (void * context, ENetPeer * peer)
+{
+    if (peer -> congestionState != NULL)
+    {
+       enet_free (peer -> congestionState);
+
+       peer -> congestionState = NULL;
+    }
+}
+
+enum
+{
+   ENET_BBR_MINIMUM_ROUND_TRIP_TIME_INTERVAL = 10000,
+   ENET_BBR_BANDWIDTH_ROUNDS                 = 10,
+   ENET_BBR_MINIMUM_SAMPLE_TIME              = 10,
+   ENET_BBR_FULL_BANDWIDTH_ROUNDS            = 3,
+   ENET_BBR_PACING_CYCLE                     = 8
+};
+
+/** Pacing gains, in quarters, cycled through once per minimum round trip time after startup. */
+static const enet_uint32 bbrPacingGains [ENET_BBR_PACING_CYCLE] = { 5, 3, 4, 4, 4, 4, 4, 4 };
+
+typedef struct _ENetBBR
+{
+   enet_uint32 minimumRoundTripTime;
+   enet_uint32 minimumRoundTripTimeStamp;
+   enet_uint32 bandwidth;                 /**< bottleneck bandwidth estimate, in bytes per second */
+   enet_uint32 bandwidthStamp;
+   enet_uint32 fullBandwidth;
+   enet_uint32 fullBandwidthRounds;
+   enet_uint32 sampleStart;
+   enet_uint32 sampleBytes;
+   enet_uint32 cycleStart;
+   enet_uint32 cycleIndex;
+   int         filledPipe;
+   double      window;
+} ENetBBR;
+
+static void ENET_CALLBACK
+enet_bbr_connect (void * context, ENetPeer * peer)
+{
+    ENetBBR * bbr = (ENetBBR *) enet_malloc (sizeof (ENetBBR));
+
+    peer -> congestionState = bbr;
+    if (bbr == NULL)
+      return;
+
+    memset (bbr, 0, sizeof (ENetBBR));
+
+    bbr -> sampleStart = peer -> host -> serviceTime;
+    bbr -> window = enet_congestion_clamp_window (peer, ENET_CONGESTION_INITIAL_WINDOW (peer));
+}
+
+static void
+enet_bbr_sample_bandwidth (ENetBBR * bbr, enet_uint32 serviceTime)
+{
+    enet_uint32 elapsed = ENET_TIME_DIFFERENCE (serviceTime, bbr -> sampleStart),
+                bandwidth;
+
+    if (elapsed < ENET_MAX (bbr -> minimumRoundTripTime, ENET_BBR_MINIMUM_SAMPLE_TIME))
+      return;
+
+    bandwidth = (enet_uint32) ((double) bbr -> sampleBytes * 1000.0 / elapsed);
+
+    if (bandwidth >= bbr -> bandwidth ||
+        ENET_TIME_DIFFERENCE (serviceTime, bbr -> bandwidthStamp) >= ENET_BBR_BANDWIDTH_ROUNDS * bbr -> minimumRoundTripTime)
+    {
+       bbr -> bandwidth = bandwidth;
+       bbr -> bandwidthStamp = serviceTime;
+    }
+
+    bbr -> sampleBytes = 0;
+    bbr -> sampleStart = serviceTime;
+
+    if (bbr -> filledPipe)
+      return;
+
+    if (bbr -> bandwidth >= bbr -> fullBandwidth + bbr -> fullBandwidth / 4)
+    {
+       bbr -> fullBandwidth = bbr -> bandwidth;
+       bbr -> fullBandwidthRounds = 0;
+    }
+    else
+    if (++ bbr -> fullBandwidthRounds >= ENET_BBR_FULL_BANDWIDTH_ROUNDS)
+    {
+       bbr -> filledPipe = 1;
+       bbr -> cycleStart = serviceTime;
+       bbr -> cycleIndex = 0;
+    }
+}
+
+static void ENET_CALLBACK
+enet_bbr_acknowledge (void * context, ENetPeer * peer, enet_uint32 acknowledgedBytes, enet_uint32 roundTripTime)
+{
+    ENetBBR * bbr = (ENetBBR *) peer -> congestionState;
+    enet_uint32 serviceTime = peer -> host -> serviceTime;
+
+    if (bbr == NULL)
+      return;
+
+    if (roundTripTime < 1)
+      roundTripTime = 1;
+
+    if (bbr -> minimumRoundTripTime == 0 ||
+        roundTripTime <= bbr -> minimumRoundTripTime ||
+        ENET_TIME_DIFFERENCE (serviceTime, bbr -> minimumRoundTripTimeStamp) >= ENET_BBR_MINIMUM_ROUND_TRIP_TIME_INTERVAL)
+    {
+       bbr -> minimumRoundTripTime = roundTripTime;
+       bbr -> minimumRoundTripTimeStamp = serviceTime;
+    }
+
+    bbr -> sampleBytes += acknowledgedBytes;
+
+    enet_bbr_sample_bandwidth (bbr, serviceTime);
+
+    if (! bbr -> filledPipe)
+    {
+       bbr -> window += acknowledgedBytes;
+
+       peer -> pacingRate = (enet_uint32) (bbr -> bandwidth * 2.885);
+    }
+    else
+    {
+       if (ENET_TIME_DIFFERENCE (serviceTime, bbr -> cycleStart) >= bbr -> minimumRoundTripTime)
+       {
+          bbr -> cycleIndex = (bbr -> cycleIndex + 1) % ENET_BBR_PACING_CYCLE;
+          bbr -> cycleStart = serviceTime;
+       }
+
+       bbr -> window = 2.0 * bbr -> bandwidth * bbr -> minimumRoundTripTime / 1000.0;
+
+       peer -> pacingRate = bbr -> bandwidth / 4 * bbrPacingGains [bbr -> cycleIndex];
+    }
+
+    bbr -> window = enet_congestion_clamp_window (peer, bbr -> window);
+}
+
+/** Sets the congestion controller the host should use to a delay-based controller in the style of BBR.
+    @param host host to change
+
+    The controller estimates each peer's bottleneck bandwidth from the rate at which reliable data
+    is acknowledged, and its minimum round trip time. After a startup phase, which grows the window
+    until the bandwidth estimate stops growing, it keeps twice the bandwidth-delay product in transit
+    and cycles its pacing rate around the bandwidth estimate. Losses do not shrink the window, which
+    suits links with random loss.
+*/
+void
+enet_host_congestion_control_with_bbr (ENetHost * host)
+{
+    ENetCongestionControl congestionControl;
+
+    memset (& congestionControl, 0, sizeof (congestionControl));
+    congestionControl.onConnect = enet_bbr_connect;
+    congestionControl.onDisconnect = enet_congestion_disconnect;
+    congestionControl.onAcknowledge = enet_bbr_acknowledge;
+
+    enet_host_congestion_control (host, & congestionControl);
+}
+
+#define ENET_CUBIC_BETA 0.7
+#define ENET_CUBIC_SCALE 0.4
+
+typedef struct _ENetCubic
+{
+   double      window;
+   double      windowMaximum;
+   double      slowStartThreshold;
+   double      origin;
+   double      period;
+   double      renoWindow;
+   enet_uint32 epochStart;
+   int         inEpoch;
+   enet_uint32 lastReduction;
+   int         hasReduced;
+} ENetCubic;
+
+static double
+enet_cubic_cube_root (double value)
+{
+    double root = value > 1.0 ? value : 1.0;
+    int i;
+
+    if (value <= 0.0)
+      return 0.0;
+
+    for (i = 0; i < 64; ++ i)
+      root -= (root * root * root - value) / (3.0 * root * root);
+
+    return root;
+}
+
+static void ENET_CALLBACK
+enet_cubic_connect (void * context, ENetPeer * peer)
+{
+    ENetCubic * cubic = (ENetCubic *) enet_malloc (sizeof (ENetCubic));
+
+    peer -> congestionState = cubic;
+    if (cubic == NULL)
+      return;
+
+    memset (cubic, 0, sizeof (ENetCubic));
+
+    cubic -> slowStartThreshold = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+    cubic -> window = enet_congestion_clamp_window (peer, ENET_CONGESTION_INITIAL_WINDOW (peer));
+}
+
+static void ENET_CALLBACK
+enet_cubic_acknowledge (void * context, ENetPeer * peer, enet_uint32 acknowledgedBytes, enet_uint32 roundTripTime)
+{
+    ENetCubic * cubic = (ENetCubic *) peer -> congestionState;
+    double elapsed, target;
+
+    if (cubic == NULL || acknowledgedBytes == 0)
+      return;
+
+    if (cubic -> window < cubic -> slowStartThreshold)
+    {
+       cubic -> window = enet_congestion_clamp_window (peer, cubic -> window + acknowledgedBytes);
+
+       return;
+    }
+
+    if (! cubic -> inEpoch)
+    {
+       cubic -> inEpoch = 1;
+       cubic -> epochStart = peer -> host -> serviceTime;
+       cubic -> renoWindow = cubic -> window;
+
+       if (cubic -> window < cubic -> windowMaximum)
+       {
+          cubic -> period = enet_cubic_cube_root ((cubic -> windowMaximum - cubic -> window) / (ENET_CUBIC_SCALE * peer -> mtu));
+          cubic -> origin = cubic -> windowMaximum;
+       }
+       else
+       {
+          cubic -> period = 0.0;
+          cubic -> origin = cubic -> window;
+       }
+    }
+
+    elapsed = (ENET_TIME_DIFFERENCE (peer -> host -> serviceTime, cubic -> epochStart) + peer -> roundTripTime) / 1000.0 - cubic -> period;
+    target = cubic -> origin + ENET_CUBIC_SCALE * peer -> mtu * elapsed * elapsed * elapsed;
+
+    if (target > cubic -> window)
+      cubic -> window += (target - cubic -> window) * acknowledgedBytes / cubic -> window;
+
+    cubic -> renoWindow += 3.0 * (1.0 - ENET_CUBIC_BETA) / (1.0 + ENET_CUBIC_BETA) * peer -> mtu * acknowledgedBytes / cubic -> renoWindow;
+    if (cubic -> renoWindow > cubic -> window)
+      cubic -> window = cubic -> renoWindow;
+
+    cubic -> window = enet_congestion_clamp_window (peer, cubic -> window);
+}
+
+static void ENET_CALLBACK
+enet_cubic_loss (void * context, ENetPeer * peer, enet_uint32 lostBytes)
+{
+    ENetCubic * cubic = (ENetCubic *) peer -> congestionState;
+
+    if (cubic == NULL ||
+        (cubic -> hasReduced &&
+          ENET_TIME_DIFFERENCE (peer -> host -> serviceTime, cubic -> lastReduction) < peer -> roundTripTime))
+      return;
+
+    cubic -> hasReduced = 1;
+    cubic -> lastReduction = peer -> host -> serviceTime;
+    cubic -> inEpoch = 0;
+
+    if (cubic -> window < cubic -> windowMaximum)
+      cubic -> windowMaximum = cubic -> window * (1.0 + ENET_CUBIC_BETA) / 2.0;
+    else
+      cubic -> windowMaximum = cubic -> window;
+
+    cubic -> window = enet_congestion_clamp_window (peer, cubic -> window * ENET_CUBIC_BETA);
+    cubic -> slowStartThreshold = cubic -> window;
+}
+
+/** Sets the congestion controller the host should use to a loss-based controller in the style of CUBIC.
+    @param host host to change
+
+    The controller grows each peer's window exponentially until the first loss, then shrinks it
+    by 30% at most once per round trip time on loss, and regrows it along a cubic curve centred
+    on the window at which the last loss happened.
+*/
+void
+enet_host_congestion_control_with_cubic (ENetHost * host)
+{
+    ENetCongestionControl congestionControl;
+
+    memset (& congestionControl, 0, sizeof (congestionControl));
+    congestionControl.onConnect = enet_cubic_connect;
+    congestionControl.onDisconnect = enet_congestion_disconnect;
+    congestionControl.onAcknowledge = enet_cubic_acknowledge;
+    congestionControl.onLoss = enet_cubic_loss;
+
+    enet_host_congestion_control (host, & congestionControl);
+}
+
+/** @} */
+
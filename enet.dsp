@@ -105,6 +105,14 @@ SOURCE=.\compress.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\congestion.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\group.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\packet.c
 # End Source File
 # Begin Source File
@@ -113,10 +121,18 @@ SOURCE=.\peer.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\pool.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\protocol.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\thread.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\unix.c
 # End Source File
 # Begin Source File
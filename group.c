@@ -0,0 +1,343 @@
+/**
+ @file  group.c
+ @brief ENet host groups sharing one address across threads
+*/
+#define ENET_BUILDING_LIB 1
+#include <string.h>
+#include "enet/enet.h"
+
+/** @defgroup group ENet host group functions
+    @{
+*/
+
+typedef struct _ENetHostBroadcast
+{
+   ENetListNode broadcastList;
+   enet_uint8   channelID;
+   ENetPacket * packet;
+} ENetHostBroadcast;
+
+static void
+enet_host_group_destroy_shards (ENetHostGroup * group, size_t shardCount)
+{
+    ENetHostShard * shard;
+
+    for (shard = group -> shards; shard < & group -> shards [shardCount]; ++ shard)
+    {
+       while (! enet_list_empty (& shard -> broadcasts))
+       {
+          ENetHostBroadcast * broadcast = (ENetHostBroadcast *) enet_list_remove (enet_list_begin (& shard -> broadcasts));
+
+          if (enet_packet_remove_reference (broadcast -> packet) == 0)
+            enet_packet_destroy (broadcast -> packet);
+
+          enet_free (broadcast);
+       }
+
+       enet_host_destroy (shard -> host);
+
+       enet_mutex_destroy (& shard -> mutex);
+    }
+}
+
+/** Creates a group of hosts that share one address, so that the peers connecting to it are
+    spread across several hosts which may each be serviced on their own thread.
+
+    @param address   the address at which other peers may connect to the group; if its port is 0, the shards share a port chosen by the system
+    @param shardCount number of hosts in the group
+    @param peerCount the maximum number of peers that should be allocated for each host of the group
+    @param channelLimit the maximum number of channels allowed; if 0, then this is equivalent to ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT
+    @param incomingBandwidth downstream bandwidth of each host in bytes/second; if 0, ENet will assume unlimited bandwidth.
+    @param outgoingBandwidth upstream bandwidth of each host in bytes/second; if 0, ENet will assume unlimited bandwidth.
+
+    @returns the group on success and NULL on failure, including when the system does not support SO_REUSEPORT
+
+    @remarks Each host of the group, found in ENetHostGroup::shards, is created as by
+    enet_host_create() and has its own socket bound to the address with SO_REUSEPORT.  A host
+    may be serviced and otherwise used from one thread only, while the enet_host_group functions
+    may be called from any thread.  On Linux, all datagrams from one source address are steered
+    to the same host, so the limit on duplicate peers of enet_host_group_duplicate_peers() holds
+    across the whole group.
+*/
+ENetHostGroup *
+enet_host_group_create (const ENetAddress * address, size_t shardCount, size_t peerCount, size_t channelLimit, enet_uint32 incomingBandwidth, enet_uint32 outgoingBandwidth)
+{
+    ENetHostGroup * group;
+    ENetAddress shardAddress;
+    size_t i;
+
+    if (address == NULL || shardCount < 1)
+      return NULL;
+
+    group = (ENetHostGroup *) enet_malloc (sizeof (ENetHostGroup) + shardCount * sizeof (ENetHostShard));
+    if (group == NULL)
+      return NULL;
+    memset (group, 0, sizeof (ENetHostGroup) + shardCount * sizeof (ENetHostShard));
+
+    if (enet_mutex_create (& group -> mutex) < 0)
+    {
+       enet_free (group);
+
+       return NULL;
+    }
+
+    group -> shards = (ENetHostShard *) & group [1];
+    group -> shardCount = 0;
+    group -> connectedPeers = 0;
+
+    shardAddress = * address;
+
+    for (i = 0; i < shardCount; ++ i)
+    {
+       ENetHostShard * shard = & group -> shards [i];
+       ENetHost * host = enet_host_create (NULL, peerCount, channelLimit, incomingBandwidth, outgoingBandwidth);
+
+       if (host == NULL)
+         goto failure;
+
+       if (enet_mutex_create (& shard -> mutex) < 0)
+       {
+          enet_host_destroy (host);
+
+          goto failure;
+       }
+
+       shard -> host = host;
+       shard -> duplicatePeers = host -> duplicatePeers;
+       enet_list_clear (& shard -> broadcasts);
+
+       ++ group -> shardCount;
+
+       if (enet_socket_set_option (host -> socket, ENET_SOCKOPT_REUSEPORT, 1) < 0 ||
+           enet_socket_bind (host -> socket, & shardAddress) < 0)
+         goto failure;
+
+       if (enet_socket_get_address (host -> socket, & host -> address) < 0)
+         host -> address = shardAddress;
+
+       shardAddress.port = host -> address.port;
+
+       host -> group = group;
+       host -> shard = shard;
+    }
+
+    group -> addressAffinity = shardCount == 1 ||
+       enet_socket_set_option (group -> shards [0].host -> socket, ENET_SOCKOPT_REUSEPORT_AFFINITY, (int) shardCount) == 0;
+
+    return group;
+
+failure:
+    enet_host_group_destroy_shards (group, group -> shardCount);
+
+    enet_mutex_destroy (& group -> mutex);
+
+    enet_free (group);
+
+    return NULL;
+}
+
+/** Destroys a host group and all of its hosts.
+    @param group pointer to the group to destroy
+    @remarks None of the group's hosts may be in use by other threads.
+*/
+void
+enet_host_group_destroy (ENetHostGroup * group)
+{
+    if (group == NULL)
+      return;
+
+    enet_host_group_destroy_shards (group, group -> shardCount);
+
+    enet_mutex_destroy (& group -> mutex);
+
+    enet_free (group);
+}
+
+/** Looks up the host of a group that receives the datagrams sent from an address.
+    @param group the group to search
+    @param address the address of the remote peer
+    @returns the host that receives datagrams from the address, or NULL if the kernel chooses it
+    by port as well and it cannot be known in advance
+
+    @remarks A connection to a remote peer made through a host group should be initiated with
+    enet_host_connect() on the host returned here, so that the remote peer's replies reach it.
+*/
+ENetHost *
+enet_host_group_select (ENetHostGroup * group, const ENetAddress * address)
+{
+    if (! group -> addressAffinity)
+      return NULL;
+
+    return group -> shards [ENET_NET_TO_HOST_32 (address -> host) % group -> shardCount].host;
+}
+
+/** Queues a packet to be sent to all peers of all hosts of a group.
+    @param group group on which to broadcast the packet
+    @param channelID channel on which to broadcast
+    @param packet packet to broadcast
+
+    @remarks May be called from any thread.  Each host broadcasts the packet to its peers at the
+    start of its next send pass, as by enet_host_broadcast(), and is woken to do so if it has
+    enabled enet_host_submission_wakeup().  A packet created with ENET_PACKET_FLAG_SHARED is
+    shared by all hosts of the group, while the hosts other than the first are otherwise given
+    their own copies of the packet.  A packet delivered with enet_host_receive_zero_copy() is
+    copied out of its receive buffer first, so it must be broadcast from the thread that
+    received it.
+*/
+void
+enet_host_group_broadcast (ENetHostGroup * group, enet_uint8 channelID, ENetPacket * packet)
+{
+    int shared = packet -> flags & ENET_PACKET_FLAG_SHARED;
+    size_t i;
+
+    if (enet_packet_detach_receive_buffer (packet) < 0)
+    {
+       if (packet -> referenceCount == 0)
+         enet_packet_destroy (packet);
+
+       return;
+    }
+
+    if (shared)
+      enet_packet_retain (packet);
+
+    for (i = group -> shardCount; i > 0; -- i)
+    {
+       ENetHostShard * shard = & group -> shards [i - 1];
+       ENetHostBroadcast * broadcast = (ENetHostBroadcast *) enet_malloc (sizeof (ENetHostBroadcast));
+       ENetPacket * shardPacket = packet;
+
+       if (broadcast == NULL)
+         continue;
+
+       if (shard != group -> shards && ! shared)
+       {
+          if (packet -> segments != NULL)
+            shardPacket = enet_packet_create_from_buffers (packet -> segments, packet -> segmentCount, packet -> flags & ~ ENET_PACKET_FLAG_NO_ALLOCATE);
+          else
+            shardPacket = enet_packet_create (packet -> data, packet -> dataLength, packet -> flags & ~ ENET_PACKET_FLAG_NO_ALLOCATE);
+
+          if (shardPacket == NULL)
+          {
+             enet_free (broadcast);
+
+             continue;
+          }
+       }
+
+       broadcast -> channelID = channelID;
+       broadcast -> packet = shardPacket;
+
+       enet_packet_add_references (shardPacket, 1);
+
+       enet_mutex_lock (& shard -> mutex);
+
+       enet_list_insert (enet_list_end (& shard -> broadcasts), broadcast);
+
+       enet_mutex_unlock (& shard -> mutex);
+
+       if (shard -> host -> submissionWakeup != ENET_SOCKET_NULL &&
+           ENET_ATOMIC_EXCHANGE (& shard -> host -> submissionWakeupPending, 1) == 0)
+         enet_socket_signal_wakeup (shard -> host -> submissionWakeup);
+
+       if (shard == group -> shards && ! shared)
+         return;
+    }
+
+    if (shared)
+      enet_packet_release (packet);
+    else
+    if (packet -> referenceCount == 0)
+      enet_packet_destroy (packet);
+}
+
+/** Returns the number of peers connected to any host of a group.
+    @param group group to query
+*/
+size_t
+enet_host_group_connected_peers (ENetHostGroup * group)
+{
+    size_t connectedPeers;
+
+    enet_mutex_lock (& group -> mutex);
+
+    connectedPeers = group -> connectedPeers;
+
+    enet_mutex_unlock (& group -> mutex);
+
+    return connectedPeers;
+}
+
+/** Limits the number of peers that may connect to a group from the same address.
+    @param group group to limit
+    @param duplicatePeers maximum number of peers per address
+
+    @remarks The limit takes effect on each host at the start of its next send pass.  It holds
+    across the whole group if ENetHostGroup::addressAffinity is set, and for each host alone
+    otherwise.
+*/
+void
+enet_host_group_duplicate_peers (ENetHostGroup * group, size_t duplicatePeers)
+{
+    ENetHostShard * shard;
+
+    for (shard = group -> shards; shard < & group -> shards [group -> shardCount]; ++ shard)
+    {
+       enet_mutex_lock (& shard -> mutex);
+
+       shard -> duplicatePeers = duplicatePeers;
+
+       enet_mutex_unlock (& shard -> mutex);
+    }
+}
+
+void
+enet_host_group_count_connected_peer (ENetHostGroup * group, int connected)
+{
+    enet_mutex_lock (& group -> mutex);
+
+    if (connected)
+      ++ group -> connectedPeers;
+    else
+      -- group -> connectedPeers;
+
+    enet_mutex_unlock (& group -> mutex);
+}
+
+/** Sends the broadcasts queued for a host of a group by enet_host_group_broadcast(), and
+    picks up the group's settings.
+*/
+void
+enet_host_group_receive_broadcasts (ENetHost * host)
+{
+    ENetHostShard * shard = host -> shard;
+    ENetList broadcasts;
+
+    enet_list_clear (& broadcasts);
+
+    (void) ENET_ATOMIC_EXCHANGE (& host -> submissionWakeupPending, 0);
+
+    enet_mutex_lock (& shard -> mutex);
+
+    host -> duplicatePeers = shard -> duplicatePeers;
+
+    if (! enet_list_empty (& shard -> broadcasts))
+      enet_list_move (enet_list_end (& broadcasts), enet_list_front (& shard -> broadcasts), enet_list_back (& shard -> broadcasts));
+
+    enet_mutex_unlock (& shard -> mutex);
+
+    while (! enet_list_empty (& broadcasts))
+    {
+       ENetHostBroadcast * broadcast = (ENetHostBroadcast *) enet_list_remove (enet_list_begin (& broadcasts));
+
+       enet_host_broadcast (host, broadcast -> channelID, broadcast -> packet);
+
+       if (enet_packet_remove_reference (broadcast -> packet) == 0)
+         enet_packet_destroy (broadcast -> packet);
+
+       enet_free (broadcast);
+    }
+}
+
+/** @} */
+
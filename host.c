@@ -30,6 +30,7 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
 {
     ENetHost * host;
     ENetPeer * currentPeer;
+    size_t i;
 
     if (peerCount > ENET_PROTOCOL_MAXIMUM_PEER_ID)
       return NULL;
@@ -107,10 +108,69 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
     host -> compressor.compress = NULL;
     host -> compressor.decompress = NULL;
     host -> compressor.destroy = NULL;
+    host -> compressor.duplicate = NULL;
+
+    memset (& host -> congestionControl, 0, sizeof (host -> congestionControl));
 
     host -> intercept = NULL;
 
+    host -> receiveBatchSize = 0;
+    host -> receiveBatchCount = 0;
+    host -> receiveBatchPosition = 0;
+    host -> receiveBatchOffset = 0;
+    host -> receiveBatch = NULL;
+    host -> receiveCoalescing = 0;
+    host -> receiveZeroCopy = 0;
+    host -> receiveBuffer = NULL;
+    host -> receiveBatchBuffers = NULL;
+    host -> receivedBuffer = NULL;
+    host -> freeReceiveBufferCount = 0;
+
+    enet_list_clear (& host -> usedReceiveBuffers);
+    enet_list_clear (& host -> freeReceiveBuffers);
+
+    host -> sendBatchSize = 0;
+    host -> sendBatchCount = 0;
+    host -> sendBatch = NULL;
+    host -> sendBatchDataCount = 0;
+    host -> sendBatchData = NULL;
+    host -> sendBatchBufferCount = 0;
+    host -> sendBatchBuffers = NULL;
+    host -> sendSegmentation = 0;
+    host -> sendReleaseTime = 0;
+    host -> acknowledgeRanges = 1;
+    host -> submissions = NULL;
+    host -> submissionMask = 0;
+    host -> submissionHead = 0;
+    host -> submissionTail = 0;
+    host -> submissionWakeupPending = 0;
+    host -> submissionWakeup = ENET_SOCKET_NULL;
+    host -> ioThreadRunning = 0;
+    host -> ioThreadStop = 0;
+    host -> ioEvents = NULL;
+    host -> ioEventMask = 0;
+    host -> ioEventHead = 0;
+    host -> ioEventTail = 0;
+    host -> sendWorkers = NULL;
+    host -> sendWorkerCount = 0;
+    host -> sendWorkerCompression = 0;
+    host -> sendWorkerStop = 0;
+    host -> sendJobCount = 0;
+    host -> sendJobNext = 0;
+
+    enet_pool_initialize (& host -> outgoingCommandPool, sizeof (ENetOutgoingCommand), ENET_HOST_POOL_SLAB_SIZE, ENET_HOST_DEFAULT_POOL_FREE_LIMIT);
+    enet_pool_initialize (& host -> incomingCommandPool, sizeof (ENetIncomingCommand), ENET_HOST_POOL_SLAB_SIZE, ENET_HOST_DEFAULT_POOL_FREE_LIMIT);
+    enet_pool_initialize (& host -> acknowledgementPool, sizeof (ENetAcknowledgement), ENET_HOST_POOL_SLAB_SIZE, ENET_HOST_DEFAULT_POOL_FREE_LIMIT);
+
     enet_list_clear (& host -> dispatchQueue);
+    enet_list_clear (& host -> activePeers);
+
+    for (i = 0; i < ENET_HOST_TIMER_WHEEL_SIZE; ++ i)
+      enet_list_clear (& host -> timerWheel [i]);
+
+    host -> timerTime = enet_time_get ();
+    host -> timerDeadline = 0;
+    host -> timerDeadlineValid = 0;
 
     for (currentPeer = host -> peers;
          currentPeer < & host -> peers [host -> peerCount];
@@ -134,6 +194,100 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
     return host;
 }
 
+/** Takes a receive buffer of the given size from the host's free buffers, or allocates a new one.
+    @param host host to receive into
+    @param dataLength capacity of the buffer
+    @returns the buffer with a single reference held by the caller, or NULL on failure
+*/
+ENetReceiveBuffer *
+enet_host_acquire_receive_buffer (ENetHost * host, size_t dataLength)
+{
+    ENetReceiveBuffer * buffer = NULL;
+
+    while (! enet_list_empty (& host -> freeReceiveBuffers))
+    {
+       buffer = (ENetReceiveBuffer *) enet_list_remove (enet_list_begin (& host -> freeReceiveBuffers));
+
+       -- host -> freeReceiveBufferCount;
+
+       if (buffer -> dataLength == dataLength)
+         break;
+
+       enet_free (buffer);
+
+       buffer = NULL;
+    }
+
+    if (buffer == NULL)
+    {
+       buffer = (ENetReceiveBuffer *) enet_malloc (sizeof (ENetReceiveBuffer) + dataLength);
+       if (buffer == NULL)
+         return NULL;
+
+       buffer -> host = host;
+       buffer -> data = (enet_uint8 *) (buffer + 1);
+       buffer -> dataLength = dataLength;
+    }
+
+    buffer -> referenceCount = 1;
+
+    enet_list_insert (enet_list_end (& host -> usedReceiveBuffers), buffer);
+
+    return buffer;
+}
+
+/** Drops a reference to a receive buffer, returning it to its host's free buffers
+    or deallocating it once it is no longer referenced.
+    @param buffer buffer to release
+*/
+void
+enet_host_release_receive_buffer (ENetReceiveBuffer * buffer)
+{
+    ENetHost * host = buffer -> host;
+
+    if (-- buffer -> referenceCount > 0)
+      return;
+
+    if (host == NULL)
+    {
+       enet_free (buffer);
+
+       return;
+    }
+
+    enet_list_remove (& buffer -> bufferList);
+
+    if (host -> freeReceiveBufferCount >= ENET_HOST_FREE_RECEIVE_BUFFERS)
+    {
+       enet_free (buffer);
+
+       return;
+    }
+
+    enet_list_insert (enet_list_begin (& host -> freeReceiveBuffers), buffer);
+
+    ++ host -> freeReceiveBufferCount;
+}
+
+static void
+enet_host_release_receive_batch_buffers (ENetHost * host)
+{
+    size_t i;
+
+    if (host -> receiveBatch == NULL)
+      return;
+
+    for (i = 0; i < host -> receiveBatchSize; ++ i)
+    {
+       if (host -> receiveBatchBuffers [i] != NULL)
+       {
+          enet_host_release_receive_buffer (host -> receiveBatchBuffers [i]);
+
+          host -> receiveBatchBuffers [i] = NULL;
+       }
+    }
+}
+
 /** Destroys the host and all resources associated with it.
     @param host pointer to the host to destroy
 */
@@ -141,12 +295,27 @@ void
 enet_host_destroy (ENetHost * host)
 {
     ENetPeer * currentPeer;
+    ENetEvent event;
 
     if (host == NULL)
       return;
 
+    enet_host_io_thread_stop (host);
+
+    while (enet_host_io_event (host, & event) > 0)
+      if (event.type == ENET_EVENT_TYPE_RECEIVE)
+        enet_packet_destroy (event.packet);
+
+    if (host -> ioEvents != NULL)
+      enet_free (host -> ioEvents);
+
+    enet_host_send_workers (host, 0);
+
     enet_socket_destroy (host -> socket);
 
+    enet_host_submission_queue (host, 0);
+    enet_host_submission_wakeup (host, 0);
+
     for (currentPeer = host -> peers;
          currentPeer < & host -> peers [host -> peerCount];
          ++ currentPeer)
@@ -157,6 +326,34 @@ enet_host_destroy (ENetHost * host)
     if (host -> compressor.context != NULL && host -> compressor.destroy)
       (* host -> compressor.destroy) (host -> compressor.context);
 
+    if (host -> congestionControl.destroy != NULL)
+      (* host -> congestionControl.destroy) (host -> congestionControl.context);
+
+    enet_host_release_receive_batch_buffers (host);
+
+    if (host -> receiveBatch != NULL)
+      enet_free (host -> receiveBatch);
+
+    if (host -> receiveBuffer != NULL)
+      enet_host_release_receive_buffer (host -> receiveBuffer);
+
+    while (! enet_list_empty (& host -> freeReceiveBuffers))
+      enet_free (enet_list_remove (enet_list_begin (& host -> freeReceiveBuffers)));
+
+    while (! enet_list_empty (& host -> usedReceiveBuffers))
+    {
+       ENetReceiveBuffer * buffer = (ENetReceiveBuffer *) enet_list_remove (enet_list_begin (& host -> usedReceiveBuffers));
+
+       buffer -> host = NULL;
+    }
+
+    if (host -> sendBatch != NULL)
+      enet_free (host -> sendBatch);
+
+    enet_pool_destroy (& host -> outgoingCommandPool);
+    enet_pool_destroy (& host -> incomingCommandPool);
+    enet_pool_destroy (& host -> acknowledgementPool);
+
     enet_free (host -> peers);
     enet_free (host);
 }
@@ -222,6 +419,7 @@ enet_host_connect (ENetHost * host, const ENetAddress * address, size_t channelC
         channel -> outgoingReliableSequenceNumber = 0;
         channel -> outgoingUnreliableSequenceNumber = 0;
         channel -> incomingReliableSequenceNumber = 0;
+        channel -> incomingReliableIndex = NULL;
         channel -> incomingUnreliableSequenceNumber = 0;
 
         enet_list_clear (& channel -> incomingReliableCommands);
@@ -232,6 +430,8 @@ enet_host_connect (ENetHost * host, const ENetAddress * address, size_t channelC
     }
         
     command.header.command = ENET_PROTOCOL_COMMAND_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+    if (host -> acknowledgeRanges)
+      command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE_RANGES;
     command.header.channelID = 0xFF;
     command.connect.outgoingPeerID = ENET_HOST_TO_NET_16 (currentPeer -> incomingPeerID);
     command.connect.incomingSessionID = currentPeer -> incomingSessionID;
@@ -262,6 +462,8 @@ enet_host_broadcast (ENetHost * host, enet_uint8 channelID, ENetPacket * packet)
 {
     ENetPeer * currentPeer;
 
+    enet_packet_add_references (packet, 1);
+
     for (currentPeer = host -> peers;
          currentPeer < & host -> peers [host -> peerCount];
          ++ currentPeer)
@@ -272,17 +474,22 @@ enet_host_broadcast (ENetHost * host, enet_uint8 channelID, ENetPacket * packet)
        enet_peer_send (currentPeer, channelID, packet);
     }
 
-    if (packet -> referenceCount == 0)
+    if (enet_packet_remove_reference (packet) == 0)
       enet_packet_destroy (packet);
 }
 
 /** Sets the packet compressor the host should use to compress and decompress packets.
     @param host host to enable or disable compression for
     @param compressor callbacks for for the packet compressor; if NULL, then compression is disabled
+    @remarks Optional callbacks of the compressor, such as ENetCompressor::duplicate, must be NULL
+    if unused, so the structure should be cleared before it is filled in.
 */
 void
 enet_host_compress (ENetHost * host, const ENetCompressor * compressor)
 {
+    if (host -> sendWorkerCount > 0)
+      enet_host_send_workers_compress (host, compressor);
+
     if (host -> compressor.context != NULL && host -> compressor.destroy)
       (* host -> compressor.destroy) (host -> compressor.context);
 
@@ -292,6 +499,52 @@ enet_host_compress (ENetHost * host, const ENetCompressor * compressor)
       host -> compressor.context = NULL;
 }
 
+/** Sets the congestion controller the host should use to limit reliable data in transit to its peers.
+    @param host host to change
+    @param congestionControl callbacks for the congestion controller; if NULL, only the packet throttle
+    limits reliable data in transit, see enet_peer_throttle_configure()
+
+    Connected peers are handed over from the previous controller to the new one, starting again from
+    an unlimited congestion window.  The packet throttle keeps adapting to round trip times under any
+    controller, so that unreliable packets are still throttled.
+    @sa enet_host_congestion_control_with_bbr()
+    @sa enet_host_congestion_control_with_cubic()
+*/
+void
+enet_host_congestion_control (ENetHost * host, const ENetCongestionControl * congestionControl)
+{
+    ENetPeer * currentPeer;
+
+    for (currentPeer = host -> peers;
+         currentPeer < & host -> peers [host -> peerCount];
+         ++ currentPeer)
+    {
+       if ((currentPeer -> state == ENET_PEER_STATE_CONNECTED || currentPeer -> state == ENET_PEER_STATE_DISCONNECT_LATER) &&
+           host -> congestionControl.onDisconnect != NULL)
+         (* host -> congestionControl.onDisconnect) (host -> congestionControl.context, currentPeer);
+
+       currentPeer -> congestionWindow = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+       currentPeer -> pacingRate = 0;
+    }
+
+    if (host -> congestionControl.destroy != NULL)
+      (* host -> congestionControl.destroy) (host -> congestionControl.context);
+
+    if (congestionControl)
+      host -> congestionControl = * congestionControl;
+    else
+      memset (& host -> congestionControl, 0, sizeof (host -> congestionControl));
+
+    for (currentPeer = host -> peers;
+         currentPeer < & host -> peers [host -> peerCount];
+         ++ currentPeer)
+    {
+       if ((currentPeer -> state == ENET_PEER_STATE_CONNECTED || currentPeer -> state == ENET_PEER_STATE_DISCONNECT_LATER) &&
+           host -> congestionControl.onConnect != NULL)
+         (* host -> congestionControl.onConnect) (host -> congestionControl.context, currentPeer);
+    }
+}
+
 /** Limits the maximum allowed channels of future incoming connections.
     @param host host to limit
     @param channelLimit the maximum number of channels allowed; if 0, then this is equivalent to ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT
@@ -324,6 +577,492 @@ enet_host_bandwidth_limit (ENetHost * host, enet_uint32 incomingBandwidth, enet_
     host -> recalculateBandwidthLimits = 1;
 }
 
+static int
+enet_host_allocate_receive_batch (ENetHost * host, size_t batchSize, size_t dataSize)
+{
+    ENetDatagram * batch;
+    ENetBuffer * buffers;
+    ENetReceiveBuffer ** receiveBuffers;
+    enet_uint8 * data;
+    size_t i;
+
+    if (host -> receiveBatchPosition < host -> receiveBatchCount)
+      return -1;
+
+    if (batchSize <= 1)
+    {
+       enet_host_release_receive_batch_buffers (host);
+
+       if (host -> receiveBatch != NULL)
+         enet_free (host -> receiveBatch);
+
+       host -> receiveBatch = NULL;
+       host -> receiveBatchBuffers = NULL;
+       host -> receiveBatchSize = 0;
+       host -> receiveBatchCount = 0;
+       host -> receiveBatchPosition = 0;
+       host -> receiveBatchOffset = 0;
+
+       return 0;
+    }
+
+    batch = (ENetDatagram *) enet_malloc (batchSize * (sizeof (ENetDatagram) + sizeof (ENetBuffer) + sizeof (ENetReceiveBuffer *) + (host -> receiveZeroCopy ? 0 : dataSize)));
+    if (batch == NULL)
+      return -1;
+
+    buffers = (ENetBuffer *) & batch [batchSize];
+    receiveBuffers = (ENetReceiveBuffer **) & buffers [batchSize];
+    data = (enet_uint8 *) & receiveBuffers [batchSize];
+
+    for (i = 0; i < batchSize; ++ i)
+    {
+       buffers [i].data = host -> receiveZeroCopy ? NULL : data + i * dataSize;
+       buffers [i].dataLength = dataSize;
+
+       receiveBuffers [i] = NULL;
+
+       batch [i].buffers = & buffers [i];
+       batch [i].bufferCount = 1;
+       batch [i].dataLength = 0;
+       batch [i].segmentSize = 0;
+       batch [i].sendDelay = 0;
+    }
+
+    enet_host_release_receive_batch_buffers (host);
+
+    if (host -> receiveBatch != NULL)
+      enet_free (host -> receiveBatch);
+
+    host -> receiveBatch = batch;
+    host -> receiveBatchBuffers = receiveBuffers;
+    host -> receiveBatchSize = batchSize;
+    host -> receiveBatchCount = 0;
+    host -> receiveBatchPosition = 0;
+    host -> receiveBatchOffset = 0;
+
+    return 0;
+}
+
+/** Sets the number of datagrams a host may receive from its socket with a single system call.
+    @param host host to adjust
+    @param batchSize maximum number of datagrams received at once; if 0 or 1, datagrams are received one at a time
+    @returns 0 on success, < 0 on failure
+
+    @remarks Datagrams received in a batch but not yet processed when an event is returned are
+    kept until the next call to enet_host_service() or enet_host_check_events().  The batch size
+    is capped at ENET_DATAGRAM_MAXIMUM.  Disabling batched receive also disables receive coalescing.
+*/
+int
+enet_host_receive_batch (ENetHost * host, size_t batchSize)
+{
+    if (batchSize > ENET_DATAGRAM_MAXIMUM)
+      batchSize = ENET_DATAGRAM_MAXIMUM;
+
+    if (batchSize == host -> receiveBatchSize ||
+        (batchSize <= 1 && host -> receiveBatchSize <= 1))
+      return 0;
+
+    if (batchSize <= 1 && host -> receiveCoalescing)
+    {
+       if (enet_host_allocate_receive_batch (host, 0, 0) < 0)
+         return -1;
+
+       enet_socket_set_option (host -> socket, ENET_SOCKOPT_UDP_GRO, 0);
+
+       host -> receiveCoalescing = 0;
+
+       return 0;
+    }
+
+    return enet_host_allocate_receive_batch (host, batchSize, host -> receiveCoalescing ? ENET_DATAGRAM_DATA_MAXIMUM : ENET_PROTOCOL_MAXIMUM_MTU);
+}
+
+/** Enables or disables receive coalescing (UDP generic receive offload) on a host.
+    @param host host to adjust
+    @param enable 1 to let the kernel coalesce incoming datagrams from the same sender, 0 to disable
+    @returns 0 on success, < 0 if the socket does not support receive coalescing or on allocation failure
+
+    @remarks Coalesced datagrams are split back into individual datagrams before they are handled.
+    Receive coalescing requires batched receives and enables them with a batch size of
+    ENET_HOST_COALESCED_RECEIVE_BATCH if enet_host_receive_batch() has not been called.
+*/
+int
+enet_host_receive_coalescing (ENetHost * host, int enable)
+{
+    if (! enable)
+    {
+       if (! host -> receiveCoalescing)
+         return 0;
+
+       if (enet_host_allocate_receive_batch (host, host -> receiveBatchSize, ENET_PROTOCOL_MAXIMUM_MTU) < 0)
+         return -1;
+
+       enet_socket_set_option (host -> socket, ENET_SOCKOPT_UDP_GRO, 0);
+
+       host -> receiveCoalescing = 0;
+
+       return 0;
+    }
+
+    if (host -> receiveCoalescing)
+      return 0;
+
+    if (enet_socket_set_option (host -> socket, ENET_SOCKOPT_UDP_GRO, 1) < 0)
+      return -1;
+
+    if (enet_host_allocate_receive_batch (host,
+          host -> receiveBatchSize > 1 ? host -> receiveBatchSize : ENET_HOST_COALESCED_RECEIVE_BATCH,
+          ENET_DATAGRAM_DATA_MAXIMUM) < 0)
+    {
+       enet_socket_set_option (host -> socket, ENET_SOCKOPT_UDP_GRO, 0);
+
+       return -1;
+    }
+
+    host -> receiveCoalescing = 1;
+
+    return 0;
+}
+
+/** Enables or disables zero-copy receive on a host.
+    @param host host to adjust
+    @param enable 1 to deliver received packets that refer to the received datagram in place, 0 to copy them
+    @returns 0 on success, < 0 if batched datagrams are still pending, if the host is serviced by
+    an I/O thread, or on allocation failure
+
+    @remarks With zero-copy receive, each datagram is received into its own reference-counted
+    buffer, and non-fragmented packets delivered by ENET_EVENT_TYPE_RECEIVE point into that buffer
+    rather than into a copy.  A buffer is recycled only once every packet referring to it has been
+    destroyed, so holding on to received packets keeps their whole datagram, or with receive
+    coalescing their whole coalesced datagram, allocated.  Until it is received, each such packet
+    therefore counts the size of its whole buffer against ENetHost::maximumWaitingData.  Packets
+    received on compressed hosts and reassembled fragments are still copied.  Buffers are recycled
+    without locking, so a received packet must only be destroyed on the thread servicing the host;
+    enet_peer_submit(), enet_host_group_broadcast() and enet_packet_retain() copy it out of its
+    buffer before it can reach another thread.
+*/
+int
+enet_host_receive_zero_copy (ENetHost * host, int enable)
+{
+    enable = enable ? 1 : 0;
+
+    if (enable == host -> receiveZeroCopy)
+      return 0;
+
+    if (enable && host -> ioThreadRunning)
+      return -1;
+
+    host -> receiveZeroCopy = enable;
+
+    if (host -> receiveBatch != NULL &&
+        enet_host_allocate_receive_batch (host, host -> receiveBatchSize, host -> receiveCoalescing ? ENET_DATAGRAM_DATA_MAXIMUM : ENET_PROTOCOL_MAXIMUM_MTU) < 0)
+    {
+       host -> receiveZeroCopy = ! enable;
+
+       return -1;
+    }
+
+    if (host -> receiveBuffer != NULL)
+    {
+       enet_host_release_receive_buffer (host -> receiveBuffer);
+
+       host -> receiveBuffer = NULL;
+    }
+
+    host -> receivedBuffer = NULL;
+
+    return 0;
+}
+
+/** Sets the number of datagrams a host may send to its socket with a single system call.
+    @param host host to adjust
+    @param batchSize maximum number of datagrams sent at once; if 0 or 1, datagrams are sent one at a time
+    @returns 0 on success, < 0 on failure
+
+    @remarks Datagrams assembled for all peers during a single enet_host_service() or enet_host_flush()
+    call are staged and sent together.  The batch size is capped at ENET_DATAGRAM_MAXIMUM.
+*/
+int
+enet_host_send_batch (ENetHost * host, size_t batchSize)
+{
+    ENetDatagram * batch;
+    ENetOutgoingDatagram * batchData;
+    size_t i;
+
+    if (batchSize > ENET_DATAGRAM_MAXIMUM)
+      batchSize = ENET_DATAGRAM_MAXIMUM;
+
+    if (batchSize == host -> sendBatchSize ||
+        (batchSize <= 1 && host -> sendBatchSize <= 1))
+      return 0;
+
+    if (batchSize <= 1)
+    {
+       enet_free (host -> sendBatch);
+
+       host -> sendBatch = NULL;
+       host -> sendBatchData = NULL;
+       host -> sendBatchBuffers = NULL;
+       host -> sendBatchSize = 0;
+       host -> sendBatchCount = 0;
+       host -> sendBatchDataCount = 0;
+       host -> sendBatchBufferCount = 0;
+       host -> sendSegmentation = 0;
+       host -> sendReleaseTime = 0;
+
+       return 0;
+    }
+
+    batch = (ENetDatagram *) enet_malloc (batchSize * (sizeof (ENetDatagram) + sizeof (ENetOutgoingDatagram) + ENET_BUFFER_MAXIMUM * sizeof (ENetBuffer)));
+    if (batch == NULL)
+      return -1;
+
+    batchData = (ENetOutgoingDatagram *) & batch [batchSize];
+
+    for (i = 0; i < batchSize; ++ i)
+    {
+       batchData [i].peer = NULL;
+       batchData [i].buffers = NULL;
+       batchData [i].bufferCount = 0;
+       batchData [i].datagram = NULL;
+
+       batch [i].buffers = NULL;
+       batch [i].bufferCount = 0;
+       batch [i].dataLength = 0;
+       batch [i].segmentSize = 0;
+       batch [i].sendDelay = 0;
+    }
+
+    if (host -> sendBatch != NULL)
+      enet_free (host -> sendBatch);
+
+    host -> sendBatch = batch;
+    host -> sendBatchData = batchData;
+    host -> sendBatchBuffers = (ENetBuffer *) & batchData [batchSize];
+    host -> sendBatchSize = batchSize;
+    host -> sendBatchCount = 0;
+    host -> sendBatchDataCount = 0;
+    host -> sendBatchBufferCount = 0;
+
+    return 0;
+}
+
+/** Enables or disables UDP segmentation offload for datagrams sent by a host.
+    @param host host to adjust
+    @param enable 1 to coalesce consecutive datagrams to the same peer into a single send, 0 to disable
+    @returns 0 on success, < 0 if the socket does not support segmentation offload
+
+    @remarks Segmentation offload requires batched sends and enables them with a batch size of
+    ENET_DATAGRAM_MAXIMUM if enet_host_send_batch() has not been called.  If the kernel later
+    rejects a coalesced datagram, segmentation offload is disabled and the datagrams are sent
+    individually.
+*/
+int
+enet_host_send_segmentation (ENetHost * host, int enable)
+{
+    if (! enable)
+    {
+       host -> sendSegmentation = 0;
+
+       return 0;
+    }
+
+    if (enet_socket_set_option (host -> socket, ENET_SOCKOPT_UDP_SEGMENT, 0) < 0)
+      return -1;
+
+    if (host -> sendBatch == NULL &&
+        enet_host_send_batch (host, ENET_DATAGRAM_MAXIMUM) < 0)
+      return -1;
+
+    host -> sendSegmentation = 1;
+
+    return 0;
+}
+
+/** Enables or disables kernel scheduled release of paced datagrams sent by a host.
+    @param host host to adjust
+    @param enable 1 to hand paced datagrams to the kernel ahead of time with a release time, 0 to disable
+    @returns 0 on success, < 0 if the socket does not support release times
+
+    @remarks Without release times, a peer with pacing enabled holds back datagrams until its
+    pacing rate allows them, so their spacing is limited by how often the host is serviced.
+    With release times, which need SO_TXTIME and a qdisc honouring it such as fq on Linux,
+    datagrams up to ENET_PEER_PACING_HORIZON milliseconds ahead of the pacing rate are sent
+    right away and the kernel releases each of them on schedule.  Release times require batched
+    sends and enable them with a batch size of ENET_DATAGRAM_MAXIMUM if enet_host_send_batch()
+    has not been called.
+    @sa enet_peer_pacing()
+*/
+int
+enet_host_send_release_time (ENetHost * host, int enable)
+{
+    if (! enable)
+    {
+       host -> sendReleaseTime = 0;
+
+       return 0;
+    }
+
+    if (enet_socket_set_option (host -> socket, ENET_SOCKOPT_TXTIME, 1) < 0)
+      return -1;
+
+    if (host -> sendBatch == NULL &&
+        enet_host_send_batch (host, ENET_DATAGRAM_MAXIMUM) < 0)
+      return -1;
+
+    host -> sendReleaseTime = 1;
+
+    return 0;
+}
+
+/** Limits the number of idle commands and acknowledgements the host keeps for reuse.
+    @param host host to limit
+    @param freeLimit number of idle objects each of the host's pools may retain; empty slabs
+    beyond this limit are released immediately
+
+    Outgoing commands, incoming commands and acknowledgements are allocated from per-host
+    slab pools, whose usage statistics are available in ENetHost::outgoingCommandPool,
+    ENetHost::incomingCommandPool and ENetHost::acknowledgementPool.
+*/
+void
+enet_host_pool_limit (ENetHost * host, size_t freeLimit)
+{
+    host -> outgoingCommandPool.freeLimit = freeLimit;
+    host -> incomingCommandPool.freeLimit = freeLimit;
+    host -> acknowledgementPool.freeLimit = freeLimit;
+
+    enet_pool_trim (& host -> outgoingCommandPool);
+    enet_pool_trim (& host -> incomingCommandPool);
+    enet_pool_trim (& host -> acknowledgementPool);
+}
+
+/** Enables or disables selective acknowledgement ranges for peers connecting to or from a host.
+    @param host host to adjust
+    @param enable 1 to acknowledge runs of reliable commands on a channel with a single
+    ENET_PROTOCOL_COMMAND_ACKNOWLEDGE_RANGE command, 0 to acknowledge each command separately
+
+    Ranges are only used with peers that also enable them, which is negotiated when the peers
+    connect, so changing this setting does not affect peers that are already connected.
+    Ranges are enabled by default.
+*/
+void
+enet_host_acknowledge_ranges (ENetHost * host, int enable)
+{
+    host -> acknowledgeRanges = enable ? 1 : 0;
+}
+
+/** Sets up or removes the queue through which other threads may submit packets to a host's peers.
+    @param host host to adjust
+    @param capacity number of packets the queue holds before enet_peer_submit() fails, rounded up
+    to a power of two; if 0, the queue is removed
+    @returns 0 on success, < 0 on failure
+
+    @remarks Must be called from the thread that services the host while no other thread submits
+    packets to it.  Packets still in a queue that is replaced or removed are sent first, as by
+    enet_peer_send().
+*/
+int
+enet_host_submission_queue (ENetHost * host, size_t capacity)
+{
+    ENetSubmission * submissions = NULL;
+    size_t submissionCount = 0, i;
+
+    if (capacity > 0)
+    {
+       for (submissionCount = 2; submissionCount < capacity; submissionCount <<= 1)
+         ;
+
+       submissions = (ENetSubmission *) enet_malloc (submissionCount * sizeof (ENetSubmission));
+       if (submissions == NULL)
+         return -1;
+
+       for (i = 0; i < submissionCount; ++ i)
+         submissions [i].sequence = i;
+    }
+
+    if (host -> submissions != NULL)
+    {
+       enet_host_drain_submissions (host);
+
+       enet_free (host -> submissions);
+    }
+
+    host -> submissions = submissions;
+    host -> submissionMask = submissionCount > 0 ? submissionCount - 1 : 0;
+    host -> submissionHead = 0;
+    host -> submissionTail = 0;
+    host -> submissionWakeupPending = 0;
+
+    return 0;
+}
+
+/** Enables or disables waking a host's service thread when packets are submitted to it.
+    @param host host to adjust
+    @param enable 1 to interrupt enet_host_service() waiting for a datagram as soon as a packet
+    is submitted with enet_peer_submit() or broadcast with enet_host_group_broadcast(), 0 to send
+    such packets only once it next wakes
+    @returns 0 on success, < 0 if the system does not support wakeups
+
+    @remarks Must be called from the thread that services the host while no other thread submits
+    packets to it.  Only supported on Linux, where the wakeup is an eventfd that is signalled at
+    most once between two send passes however many packets are submitted.
+*/
+int
+enet_host_submission_wakeup (ENetHost * host, int enable)
+{
+    if (! enable)
+    {
+       if (host -> submissionWakeup != ENET_SOCKET_NULL)
+       {
+          enet_socket_destroy (host -> submissionWakeup);
+
+          host -> submissionWakeup = ENET_SOCKET_NULL;
+       }
+
+       return 0;
+    }
+
+    if (host -> submissionWakeup == ENET_SOCKET_NULL)
+      host -> submissionWakeup = enet_socket_create_wakeup ();
+
+    return host -> submissionWakeup != ENET_SOCKET_NULL ? 0 : -1;
+}
+
+/** Queues the packets submitted to a host with enet_peer_submit() on their peers.  At most one
+    queue's worth is taken per call, so that producers cannot hold up the service thread.
+*/
+void
+enet_host_drain_submissions (ENetHost * host)
+{
+    size_t submissionCount;
+
+    (void) ENET_ATOMIC_EXCHANGE (& host -> submissionWakeupPending, 0);
+
+    for (submissionCount = host -> submissionMask + 1; submissionCount > 0; -- submissionCount)
+    {
+       ENetSubmission * submission = & host -> submissions [host -> submissionTail & host -> submissionMask];
+       ENetPeer * peer;
+       ENetPacket * packet;
+       enet_uint8 channelID;
+
+       if (ENET_ATOMIC_LOAD (& submission -> sequence) != host -> submissionTail + 1)
+         break;
+
+       peer = submission -> peer;
+       packet = submission -> packet;
+       channelID = submission -> channelID;
+
+       ENET_ATOMIC_STORE (& submission -> sequence, host -> submissionTail + host -> submissionMask + 1);
+
+       ++ host -> submissionTail;
+
+       enet_peer_send (peer, channelID, packet);
+
+       if (enet_packet_remove_reference (packet) == 0)
+         enet_packet_destroy (packet);
+    }
+}
+
 void
 enet_host_bandwidth_throttle (ENetHost * host)
 {
@@ -62,7 +62,12 @@ typedef enum _ENetSocketOption
    ENET_SOCKOPT_RCVTIMEO  = 6,
    ENET_SOCKOPT_SNDTIMEO  = 7,
    ENET_SOCKOPT_ERROR     = 8,
-   ENET_SOCKOPT_NODELAY   = 9
+   ENET_SOCKOPT_NODELAY   = 9,
+   ENET_SOCKOPT_UDP_SEGMENT = 10,
+   ENET_SOCKOPT_UDP_GRO   = 11,
+   ENET_SOCKOPT_TXTIME    = 12,
+   ENET_SOCKOPT_REUSEPORT = 13,
+   ENET_SOCKOPT_REUSEPORT_AFFINITY = 14
 } ENetSocketOption;
 
 typedef enum _ENetSocketShutdown
@@ -92,6 +97,48 @@ typedef struct _ENetAddress
    enet_uint16 port;
 } ENetAddress;
 
+#ifndef ENET_DATAGRAM_MAXIMUM
+#define ENET_DATAGRAM_MAXIMUM 64
+#endif
+
+#ifndef ENET_DATAGRAM_SEGMENT_MAXIMUM
+#define ENET_DATAGRAM_SEGMENT_MAXIMUM 64
+#endif
+
+#ifndef ENET_DATAGRAM_BUFFER_MAXIMUM
+#define ENET_DATAGRAM_BUFFER_MAXIMUM 1024
+#endif
+
+#ifndef ENET_DATAGRAM_DATA_MAXIMUM
+#define ENET_DATAGRAM_DATA_MAXIMUM 65507
+#endif
+
+/**
+ * A single datagram as sent or received by enet_socket_send_multiple() and
+ * enet_socket_receive_multiple().
+ *
+ * The buffers field describes the memory the datagram is gathered from or
+ * scattered into, and the dataLength field is set to the number of bytes that
+ * were actually transferred.  A received datagram that did not fit its buffers
+ * is discarded and reported with a dataLength of 0.  A non-zero segmentSize on
+ * a sent datagram asks the kernel to split it into datagrams of that size,
+ * which requires the socket to support ENET_SOCKOPT_UDP_SEGMENT.  On a received
+ * datagram it reports that the kernel coalesced datagrams of that size, which
+ * happens only once ENET_SOCKOPT_UDP_GRO is enabled.  A non-zero sendDelay on
+ * a sent datagram asks the kernel to hold it back for that many microseconds
+ * before releasing it onto the network, which requires the socket to support
+ * ENET_SOCKOPT_TXTIME.
+ */
+typedef struct _ENetDatagram
+{
+   ENetAddress  address;     /**< destination or source address of the datagram */
+   ENetBuffer * buffers;     /**< buffers holding the datagram data */
+   size_t       bufferCount; /**< number of buffers */
+   size_t       dataLength;  /**< number of bytes transferred */
+   size_t       segmentSize; /**< size of each segment of a coalesced datagram, or 0 */
+   enet_uint32  sendDelay;   /**< microseconds the kernel should hold a sent datagram back, or 0 */
+} ENetDatagram;
+
 /**
  * Packet flag bit constants.
  *
@@ -115,6 +162,9 @@ typedef enum _ENetPacketFlag
    /** packet will be fragmented using unreliable (instead of reliable) sends
      * if it exceeds the MTU */
    ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT = (1 << 3),
+   /** packet's reference count is maintained atomically, so that it may be queued
+     * on several hosts serviced by different threads at once */
+   ENET_PACKET_FLAG_SHARED      = (1 << 4),
 
    /** whether the packet has been sent from all queues it has been entered into */
    ENET_PACKET_FLAG_SENT = (1<<8)
@@ -122,6 +172,20 @@ typedef enum _ENetPacketFlag
 
 typedef void (ENET_CALLBACK * ENetPacketFreeCallback) (struct _ENetPacket *);
 
+/** A reference-counted buffer that a host receives datagrams into, so that
+    received packets may refer to their payload in place.
+
+    @sa enet_host_receive_zero_copy()
+ */
+typedef struct _ENetReceiveBuffer
+{
+   ENetListNode       bufferList;
+   struct _ENetHost * host;
+   size_t             referenceCount;
+   enet_uint8 *       data;
+   size_t             dataLength;
+} ENetReceiveBuffer;
+
 /**
  * ENet packet structure.
  *
@@ -138,6 +202,9 @@ typedef void (ENET_CALLBACK * ENetPacketFreeCallback) (struct _ENetPacket *);
  *    (not supported for reliable packets)
  *
  *    ENET_PACKET_FLAG_NO_ALLOCATE - packet will not allocate data, and user must supply it instead
+ *
+ *    ENET_PACKET_FLAG_SHARED - packet may be queued on hosts serviced by different threads at once,
+ *    see enet_packet_retain()
  
    @sa ENetPacketFlag
  */
@@ -149,12 +216,18 @@ typedef struct _ENetPacket
    size_t                   dataLength;      /**< length of data */
    ENetPacketFreeCallback   freeCallback;    /**< function to be called when the packet is no longer in use */
    void *                   userData;        /**< application private data, may be freely modified */
+   ENetReceiveBuffer *      receiveBuffer;   /**< internal use only */
+   ENetBuffer *             segments;        /**< user buffers holding the data of a packet created by enet_packet_create_from_buffers(), or NULL if data is contiguous */
+   size_t                   segmentCount;    /**< number of user buffers in segments */
+   size_t                   capacity;        /**< number of bytes data may grow to without reallocation */
+   size_t                   headroom;        /**< number of bytes reserved in front of data for enet_packet_prepend() */
 } ENetPacket;
 
 typedef struct _ENetAcknowledgement
 {
    ENetListNode acknowledgementList;
    enet_uint32  sentTime;
+   enet_uint32  queueTime;
    ENetProtocol command;
 } ENetAcknowledgement;
 
@@ -171,8 +244,22 @@ typedef struct _ENetOutgoingCommand
    enet_uint16  sendAttempts;
    ENetProtocol command;
    ENetPacket * packet;
+   struct _ENetOutgoingCommand * nextIndexedCommand;
+   int          isInTransit;
+   struct _ENetOutgoingCommandBlock * block;
+   enet_uint32  streamFragments;  /**< fragments a streaming command has yet to emit, 0 for ordinary commands */
+   enet_uint32  laterAcknowledgements; /**< commands sent after this one that were acknowledged since it was last sent */
 } ENetOutgoingCommand;
 
+/** Contiguous block of fragment commands shared by all fragments of a large packet.
+    The block is freed once the last of its commands has been released.
+ */
+typedef struct _ENetOutgoingCommandBlock
+{
+   size_t              referenceCount;
+   ENetOutgoingCommand commands [1];
+} ENetOutgoingCommandBlock;
+
 typedef struct _ENetIncomingCommand
 {  
    ENetListNode     incomingCommandList;
@@ -203,6 +290,10 @@ typedef enum _ENetPeerState
 #define ENET_BUFFER_MAXIMUM (1 + 2 * ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS)
 #endif
 
+#ifndef ENET_PACKET_SEGMENT_MAXIMUM
+#define ENET_PACKET_SEGMENT_MAXIMUM 16
+#endif
+
 enum
 {
    ENET_HOST_RECEIVE_BUFFER_SIZE          = 256 * 1024,
@@ -211,6 +302,12 @@ enum
    ENET_HOST_DEFAULT_MTU                  = 1400,
    ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE  = 32 * 1024 * 1024,
    ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA = 32 * 1024 * 1024,
+   ENET_HOST_COALESCED_RECEIVE_BATCH      = 8,
+   ENET_HOST_TIMER_WHEEL_SIZE             = 1024,
+   ENET_HOST_POOL_SLAB_SIZE               = 64,
+   ENET_HOST_DEFAULT_POOL_FREE_LIMIT      = 1024,
+   ENET_HOST_FREE_RECEIVE_BUFFERS         = 64,
+   ENET_HOST_IO_THREAD_WAIT               = 10,
 
    ENET_PEER_DEFAULT_ROUND_TRIP_TIME      = 500,
    ENET_PEER_DEFAULT_PACKET_THROTTLE      = 32,
@@ -231,7 +328,11 @@ enum
    ENET_PEER_FREE_UNSEQUENCED_WINDOWS     = 32,
    ENET_PEER_RELIABLE_WINDOWS             = 16,
    ENET_PEER_RELIABLE_WINDOW_SIZE         = 0x1000,
-   ENET_PEER_FREE_RELIABLE_WINDOWS        = 8
+   ENET_PEER_FREE_RELIABLE_WINDOWS        = 8,
+   ENET_PEER_PACING_BURST_TIME            = 2,
+   ENET_PEER_PACING_HORIZON               = 10,
+   ENET_PEER_SENT_RELIABLE_INDEX_SIZE     = 64,
+   ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE    = 256
 };
 
 typedef struct _ENetChannel
@@ -244,6 +345,7 @@ typedef struct _ENetChannel
    enet_uint16  incomingUnreliableSequenceNumber;
    ENetList     incomingReliableCommands;
    ENetList     incomingUnreliableCommands;
+   ENetIncomingCommand *** incomingReliableIndex;
 } ENetChannel;
 
 /**
@@ -293,6 +395,16 @@ typedef struct _ENetPeer
    enet_uint32   timeoutLimit;
    enet_uint32   timeoutMinimum;
    enet_uint32   timeoutMaximum;
+   enet_uint32   acknowledgementDelay;     /**< longest time, in milliseconds, acknowledgements are held back waiting for outgoing data, see enet_peer_acknowledgement_delay() */
+   enet_uint32   acknowledgementThreshold; /**< number of held acknowledgements that forces them out early, or 0 for no limit */
+   enet_uint32   acknowledgementCount;     /**< number of acknowledgements queued to the peer */
+   enet_uint32   fastRetransmitThreshold;  /**< later acknowledgements that cause an unacknowledged reliable command to be resent early, or 0 to wait for its timeout, see enet_peer_fast_retransmit() */
+   enet_uint32   congestionWindow;         /**< reliable data, in bytes, the host's congestion controller allows in transit, see enet_host_congestion_control() */
+   enet_uint32   pacingRate;               /**< rate, in bytes per second, at which the host's congestion controller wants data sent, or 0 if it does not pace */
+   void *        congestionState;          /**< per-peer state of the host's congestion controller */
+   int           pacing;                   /**< spread datagrams out over time instead of sending them in bursts, see enet_peer_pacing() */
+   int           pacingTokens;             /**< bytes the peer may send before it has to wait for its pacing rate, negative once sent ahead of it */
+   enet_uint32   pacingTime;
    enet_uint32   lastRoundTripTime;
    enet_uint32   lowestRoundTripTime;
    enet_uint32   lastRoundTripTimeVariance;
@@ -308,16 +420,27 @@ typedef struct _ENetPeer
    ENetList      sentUnreliableCommands;
    ENetList      outgoingReliableCommands;
    ENetList      outgoingUnreliableCommands;
+   ENetOutgoingCommand ** sentReliableIndex;          /**< reliable commands sent but not yet acknowledged, hashed by channel and sequence number */
+   size_t        sentReliableIndexSize;
+   size_t        sentReliableIndexCount;
+   size_t        sentReliableUnindexed;
    ENetList      dispatchedCommands;
    int           needsDispatch;
+   ENetListNode  activeList;
+   int           isActive;
+   int           isScheduled;
+   enet_uint32   timerDeadline;
    enet_uint16   incomingUnsequencedGroup;
    enet_uint16   outgoingUnsequencedGroup;
    enet_uint32   unsequencedWindow [ENET_PEER_UNSEQUENCED_WINDOW_SIZE / 32]; 
    enet_uint32   eventData;
    size_t        totalWaitingData;
+   int           acknowledgeRanges;        /**< whether the peer accepts ENET_PROTOCOL_COMMAND_ACKNOWLEDGE_RANGE, as negotiated on connect */
 } ENetPeer;
 
 /** An ENet packet compressor for compressing UDP packets before socket sends or receives.
+    The structure should be cleared, as with memset(), before its fields are filled in, so that
+    any optional callback left unset is NULL.
  */
 typedef struct _ENetCompressor
 {
@@ -329,13 +452,90 @@ typedef struct _ENetCompressor
    size_t (ENET_CALLBACK * decompress) (void * context, const enet_uint8 * inData, size_t inLimit, enet_uint8 * outData, size_t outLimit);
    /** Destroys the context when compression is disabled or the host is destroyed. May be NULL. */
    void (ENET_CALLBACK * destroy) (void * context);
+   /** Creates another context like context, for a send worker to compress with on its own thread, see enet_host_send_workers(). May be NULL, in which case datagrams are only compressed by the thread servicing the host. */
+   void * (ENET_CALLBACK * duplicate) (void * context);
 } ENetCompressor;
 
+/** An ENet congestion controller, which sets ENetPeer::congestionWindow and ENetPeer::pacingRate
+    of each connected peer from the acknowledgement and loss of reliable data sent to it.
+    All callbacks may be NULL.
+ */
+typedef struct _ENetCongestionControl
+{
+   /** Context data for the congestion controller. May be NULL. */
+   void * context;
+   /** Sets up the controller's state for a peer that has just connected. */
+   void (ENET_CALLBACK * onConnect) (void * context, ENetPeer * peer);
+   /** Releases the controller's state for a peer that is disconnecting or being reset. */
+   void (ENET_CALLBACK * onDisconnect) (void * context, ENetPeer * peer);
+   /** Reports an acknowledgement, which retired acknowledgedBytes of reliable data and measured roundTripTime milliseconds.
+       While this callback is set, the packet throttle still drops unreliable packets but only its bandwidth limit applies to reliable data. */
+   void (ENET_CALLBACK * onAcknowledge) (void * context, ENetPeer * peer, enet_uint32 acknowledgedBytes, enet_uint32 roundTripTime);
+   /** Reports lostBytes of reliable data about to be resent after a timeout or fast retransmission. */
+   void (ENET_CALLBACK * onLoss) (void * context, ENetPeer * peer, enet_uint32 lostBytes);
+   /** Reports sentBytes of reliable data sent, or resent, to the peer. */
+   void (ENET_CALLBACK * onSend) (void * context, ENetPeer * peer, enet_uint32 sentBytes);
+   /** Destroys the context when the controller is replaced or the host is destroyed. */
+   void (ENET_CALLBACK * destroy) (void * context);
+} ENetCongestionControl;
+
+/** A datagram assembled by the host and staged for a batched send.
+ */
+typedef struct _ENetOutgoingDatagram
+{
+   struct _ENetPeer * peer;
+   ENetBuffer * buffers;
+   size_t       bufferCount;
+   enet_uint8   headerData [sizeof (ENetProtocolHeader) + sizeof (enet_uint32)];
+   ENetProtocol commands [ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS];
+   enet_uint8   packetData [ENET_PROTOCOL_MAXIMUM_MTU];
+   ENetDatagram * datagram;  /**< batched datagram still to be compressed and checksummed by a send worker, or NULL */
+   size_t       compressedSize; /**< size of the commands already compressed into packetData when the datagram was staged, or 0 */
+} ENetOutgoingDatagram;
+
+/** A thread that compresses and checksums the datagrams staged by a host's send pass.
+
+    @sa enet_host_send_workers()
+ */
+typedef struct _ENetSendWorker
+{
+   struct _ENetHost * host;
+   ENetThread         thread;
+   void *             compressorContext; /**< the worker's own context for the host's compressor, or NULL */
+} ENetSendWorker;
+
+/** A pool of fixed-size objects carved out of larger slabs and recycled through free lists.
+ */
+typedef struct _ENetPool
+{
+   size_t      objectSize;
+   size_t      slabSize;         /**< number of objects carved out of each slab */
+   size_t      freeLimit;        /**< number of idle objects retained before empty slabs are released */
+   ENetList    freeSlabs;
+   size_t      slabCount;        /**< number of slabs currently allocated */
+   size_t      freeObjects;      /**< number of idle objects held in allocated slabs */
+   size_t      usedObjects;      /**< number of objects currently in use */
+   size_t      peakObjects;      /**< largest number of objects in use at once */
+   enet_uint32 totalAllocations; /**< total objects handed out, user should reset to 0 as needed to prevent overflow */
+} ENetPool;
+
 /** Callback that computes the checksum of the data held in buffers[0:bufferCount-1] */
 typedef enet_uint32 (ENET_CALLBACK * ENetChecksumCallback) (const ENetBuffer * buffers, size_t bufferCount);
 
 /** Callback for intercepting received raw UDP packets. Should return 1 to intercept, 0 to ignore, or -1 to propagate an error. */
 typedef int (ENET_CALLBACK * ENetInterceptCallback) (struct _ENetHost * host, struct _ENetEvent * event);
+
+/** Callback run by a thread created with enet_thread_create(). */
+typedef void (ENET_CALLBACK * ENetThreadCallback) (void * context);
+
+/** A packet submitted to a host from another thread, see enet_peer_submit(). */
+typedef struct _ENetSubmission
+{
+   size_t       sequence;
+   ENetPeer *   peer;
+   ENetPacket * packet;
+   enet_uint8   channelID;
+} ENetSubmission;
  
 /** An ENet host for communicating with peers.
   *
@@ -352,6 +552,16 @@ typedef int (ENET_CALLBACK * ENetInterceptCallback) (struct _ENetHost * host, st
     @sa enet_host_channel_limit()
     @sa enet_host_bandwidth_limit()
     @sa enet_host_bandwidth_throttle()
+    @sa enet_host_next_timeout()
+    @sa enet_host_receive_batch()
+    @sa enet_host_receive_coalescing()
+    @sa enet_host_receive_zero_copy()
+    @sa enet_host_send_batch()
+    @sa enet_host_send_segmentation()
+    @sa enet_host_pool_limit()
+    @sa enet_host_submission_queue()
+    @sa enet_host_io_thread_start()
+    @sa enet_host_send_workers()
   */
 typedef struct _ENetHost
 {
@@ -368,6 +578,11 @@ typedef struct _ENetHost
    size_t               channelLimit;                /**< maximum number of channels allowed for connected peers */
    enet_uint32          serviceTime;
    ENetList             dispatchQueue;
+   ENetList             activePeers;                 /**< peers that may have outgoing work, visited by the send loop */
+   ENetList             timerWheel [ENET_HOST_TIMER_WHEEL_SIZE]; /**< idle peers hashed by the time of their next retransmit or ping deadline */
+   enet_uint32          timerTime;
+   enet_uint32          timerDeadline;
+   int                  timerDeadlineValid;
    int                  continueSending;
    size_t               packetSize;
    enet_uint16          headerFlags;
@@ -377,6 +592,7 @@ typedef struct _ENetHost
    size_t               bufferCount;
    ENetChecksumCallback checksum;                    /**< callback the user can set to enable packet checksums for this host */
    ENetCompressor       compressor;
+   ENetCongestionControl congestionControl;          /**< congestion controller for reliable data, see enet_host_congestion_control() */
    enet_uint8           packetData [2][ENET_PROTOCOL_MAXIMUM_MTU];
    ENetAddress          receivedAddress;
    enet_uint8 *         receivedData;
@@ -391,8 +607,91 @@ typedef struct _ENetHost
    size_t               duplicatePeers;              /**< optional number of allowed peers from duplicate IPs, defaults to ENET_PROTOCOL_MAXIMUM_PEER_ID */
    size_t               maximumPacketSize;           /**< the maximum allowable packet size that may be sent or received on a peer */
    size_t               maximumWaitingData;          /**< the maximum aggregate amount of buffer space a peer may use waiting for packets to be delivered */
+   size_t               receiveBatchSize;            /**< number of datagrams received per system call, see enet_host_receive_batch() */
+   size_t               receiveBatchCount;
+   size_t               receiveBatchPosition;
+   size_t               receiveBatchOffset;
+   ENetDatagram *       receiveBatch;
+   int                  receiveCoalescing;           /**< split datagrams coalesced by the kernel, see enet_host_receive_coalescing() */
+   int                  receiveZeroCopy;             /**< deliver packets that refer to the received datagram in place, see enet_host_receive_zero_copy() */
+   ENetReceiveBuffer *  receiveBuffer;
+   ENetReceiveBuffer ** receiveBatchBuffers;
+   ENetReceiveBuffer *  receivedBuffer;
+   ENetList             usedReceiveBuffers;
+   ENetList             freeReceiveBuffers;
+   size_t               freeReceiveBufferCount;
+   size_t               sendBatchSize;               /**< number of datagrams sent per system call, see enet_host_send_batch() */
+   size_t               sendBatchCount;
+   ENetDatagram *       sendBatch;
+   size_t               sendBatchDataCount;
+   ENetOutgoingDatagram * sendBatchData;
+   size_t               sendBatchBufferCount;
+   ENetBuffer *         sendBatchBuffers;
+   int                  sendSegmentation;            /**< coalesce datagrams to a peer with UDP segmentation offload, see enet_host_send_segmentation() */
+   int                  sendReleaseTime;             /**< let the kernel release paced datagrams on schedule, see enet_host_send_release_time() */
+   int                  acknowledgeRanges;           /**< offer selective acknowledgement ranges to connecting peers, see enet_host_acknowledge_ranges() */
+   ENetPool             outgoingCommandPool;         /**< pool of outgoing commands for all peers of this host, see enet_host_pool_limit() */
+   ENetPool             incomingCommandPool;         /**< pool of incoming commands for all peers of this host */
+   ENetPool             acknowledgementPool;         /**< pool of pending acknowledgements for all peers of this host */
+   struct _ENetHostGroup * group;                    /**< group the host is a shard of, or NULL, see enet_host_group_create() */
+   struct _ENetHostShard * shard;
+   ENetSubmission *     submissions;                 /**< ring of packets submitted from other threads, see enet_host_submission_queue() */
+   size_t               submissionMask;
+   size_t               submissionHead;
+   size_t               submissionTail;
+   size_t               submissionWakeupPending;
+   ENetSocket           submissionWakeup;            /**< event that wakes enet_host_service() when packets are submitted, see enet_host_submission_wakeup() */
+   ENetThread           ioThread;                    /**< thread servicing the host, see enet_host_io_thread_start() */
+   int                  ioThreadRunning;
+   size_t               ioThreadStop;
+   ENetMutex            ioMutex;
+   struct _ENetEvent *  ioEvents;                    /**< ring of events published by the I/O thread, see enet_host_io_event() */
+   size_t               ioEventMask;
+   size_t               ioEventHead;
+   size_t               ioEventTail;
+   ENetSendWorker *     sendWorkers;                 /**< threads finishing staged datagrams in parallel, see enet_host_send_workers() */
+   size_t               sendWorkerCount;
+   int                  sendWorkerCompression;       /**< whether every send worker has a context for the host's compressor */
+   size_t               sendWorkerStop;
+   ENetSemaphore        sendWorkerStart;
+   ENetSemaphore        sendWorkerDone;
+   size_t               sendJobCount;
+   size_t               sendJobNext;
 } ENetHost;
 
+/**
+ * One host of a host group, along with the broadcasts other threads have
+ * queued for it.
+ */
+typedef struct _ENetHostShard
+{
+   ENetHost *  host;
+   ENetMutex   mutex;          /**< protects the fields below */
+   ENetList    broadcasts;
+   size_t      duplicatePeers;
+} ENetHostShard;
+
+/**
+ * A group of hosts sharing one address through SO_REUSEPORT, each of which
+ * may be serviced on its own thread.
+ *
+ * Datagrams are spread across the shards by the kernel.  Where possible the
+ * group steers all datagrams from one source address to the same shard, in
+ * which case addressAffinity is set and enet_host_group_select() tells which
+ * shard that is.  Otherwise the kernel picks a shard by source address and
+ * port.
+ *
+ * @sa enet_host_group_create()
+ */
+typedef struct _ENetHostGroup
+{
+   ENetHostShard * shards;
+   size_t          shardCount;
+   int             addressAffinity; /**< datagrams are steered to a shard by source address alone */
+   ENetMutex       mutex;           /**< protects connectedPeers */
+   size_t          connectedPeers;  /**< number of connected peers across all shards, see enet_host_group_connected_peers() */
+} ENetHostGroup;
+
 /**
  * An ENet event type, as specified in @ref ENetEvent.
  */
@@ -494,8 +793,13 @@ ENET_API int        enet_socket_listen (ENetSocket, int);
 ENET_API ENetSocket enet_socket_accept (ENetSocket, ENetAddress *);
 ENET_API int        enet_socket_connect (ENetSocket, const ENetAddress *);
 ENET_API int        enet_socket_send (ENetSocket, const ENetAddress *, const ENetBuffer *, size_t);
+ENET_API int        enet_socket_send_multiple (ENetSocket, ENetDatagram *, size_t);
 ENET_API int        enet_socket_receive (ENetSocket, ENetAddress *, ENetBuffer *, size_t);
+ENET_API int        enet_socket_receive_multiple (ENetSocket, ENetDatagram *, size_t);
 ENET_API int        enet_socket_wait (ENetSocket, enet_uint32 *, enet_uint32);
+ENET_API ENetSocket enet_socket_create_wakeup (void);
+ENET_API int        enet_socket_signal_wakeup (ENetSocket);
+ENET_API int        enet_socket_wait_wakeup (ENetSocket, ENetSocket, enet_uint32 *, enet_uint32);
 ENET_API int        enet_socket_set_option (ENetSocket, ENetSocketOption, int);
 ENET_API int        enet_socket_get_option (ENetSocket, ENetSocketOption, int *);
 ENET_API int        enet_socket_shutdown (ENetSocket, ENetSocketShutdown);
@@ -504,6 +808,17 @@ ENET_API int        enet_socketset_select (ENetSocket, ENetSocketSet *, ENetSock
 
 /** @} */
 
+extern int  enet_mutex_create (ENetMutex *);
+extern void enet_mutex_destroy (ENetMutex *);
+extern void enet_mutex_lock (ENetMutex *);
+extern void enet_mutex_unlock (ENetMutex *);
+extern int  enet_thread_create (ENetThread *, ENetThreadCallback, void *);
+extern void enet_thread_join (ENetThread *);
+extern int  enet_semaphore_create (ENetSemaphore *);
+extern void enet_semaphore_destroy (ENetSemaphore *);
+extern void enet_semaphore_wait (ENetSemaphore *);
+extern void enet_semaphore_post (ENetSemaphore *);
+
 /** @defgroup Address ENet address functions
     @{
 */
@@ -540,29 +855,75 @@ ENET_API int enet_address_get_host (const ENetAddress * address, char * hostName
 /** @} */
 
 ENET_API ENetPacket * enet_packet_create (const void *, size_t, enet_uint32);
+ENET_API ENetPacket * enet_packet_create_from_buffers (const ENetBuffer *, size_t, enet_uint32);
 ENET_API void         enet_packet_destroy (ENetPacket *);
+ENET_API ENetPacket * enet_packet_create_with_capacity (const void *, size_t, size_t, size_t, enet_uint32);
 ENET_API int          enet_packet_resize  (ENetPacket *, size_t);
+ENET_API int          enet_packet_prepend (ENetPacket *, const void *, size_t);
 ENET_API enet_uint32  enet_crc32 (const ENetBuffer *, size_t);
+extern   ENetPacket * enet_packet_create_from_receive_buffer (ENetReceiveBuffer *, const void *, size_t, enet_uint32);
+extern   size_t       enet_packet_gather (const ENetPacket *, size_t, size_t, ENetBuffer *, size_t);
+ENET_API void         enet_packet_retain (ENetPacket *);
+ENET_API void         enet_packet_release (ENetPacket *);
+extern   void         enet_packet_add_references (ENetPacket *, size_t);
+extern   size_t       enet_packet_remove_reference (ENetPacket *);
+extern   int          enet_packet_detach_receive_buffer (ENetPacket *);
                 
 ENET_API ENetHost * enet_host_create (const ENetAddress *, size_t, size_t, enet_uint32, enet_uint32);
 ENET_API void       enet_host_destroy (ENetHost *);
+ENET_API ENetHostGroup * enet_host_group_create (const ENetAddress *, size_t, size_t, size_t, enet_uint32, enet_uint32);
+ENET_API void       enet_host_group_destroy (ENetHostGroup *);
+ENET_API ENetHost * enet_host_group_select (ENetHostGroup *, const ENetAddress *);
+ENET_API void       enet_host_group_broadcast (ENetHostGroup *, enet_uint8, ENetPacket *);
+ENET_API size_t     enet_host_group_connected_peers (ENetHostGroup *);
+ENET_API void       enet_host_group_duplicate_peers (ENetHostGroup *, size_t);
+extern   void       enet_host_group_count_connected_peer (ENetHostGroup *, int);
+extern   void       enet_host_group_receive_broadcasts (ENetHost *);
 ENET_API ENetPeer * enet_host_connect (ENetHost *, const ENetAddress *, size_t, enet_uint32);
 ENET_API int        enet_host_check_events (ENetHost *, ENetEvent *);
 ENET_API int        enet_host_service (ENetHost *, ENetEvent *, enet_uint32);
 ENET_API void       enet_host_flush (ENetHost *);
+ENET_API enet_uint32 enet_host_next_timeout (ENetHost *);
 ENET_API void       enet_host_broadcast (ENetHost *, enet_uint8, ENetPacket *);
 ENET_API void       enet_host_compress (ENetHost *, const ENetCompressor *);
 ENET_API int        enet_host_compress_with_range_coder (ENetHost * host);
+ENET_API void       enet_host_congestion_control (ENetHost *, const ENetCongestionControl *);
+ENET_API void       enet_host_congestion_control_with_bbr (ENetHost *);
+ENET_API void       enet_host_congestion_control_with_cubic (ENetHost *);
 ENET_API void       enet_host_channel_limit (ENetHost *, size_t);
 ENET_API void       enet_host_bandwidth_limit (ENetHost *, enet_uint32, enet_uint32);
+ENET_API int        enet_host_receive_batch (ENetHost *, size_t);
+ENET_API int        enet_host_receive_coalescing (ENetHost *, int);
+ENET_API int        enet_host_receive_zero_copy (ENetHost *, int);
+ENET_API int        enet_host_send_batch (ENetHost *, size_t);
+ENET_API int        enet_host_send_segmentation (ENetHost *, int);
+ENET_API int        enet_host_send_release_time (ENetHost *, int);
+ENET_API void       enet_host_pool_limit (ENetHost *, size_t);
+ENET_API void       enet_host_acknowledge_ranges (ENetHost *, int);
+ENET_API int        enet_host_submission_queue (ENetHost *, size_t);
+ENET_API int        enet_host_submission_wakeup (ENetHost *, int);
+extern   void       enet_host_drain_submissions (ENetHost *);
+ENET_API int        enet_host_io_thread_start (ENetHost *, size_t);
+ENET_API void       enet_host_io_thread_stop (ENetHost *);
+ENET_API int        enet_host_io_event (ENetHost *, ENetEvent *);
+ENET_API void       enet_host_io_lock (ENetHost *);
+ENET_API void       enet_host_io_unlock (ENetHost *);
+ENET_API int        enet_host_send_workers (ENetHost *, size_t);
+extern   void       enet_host_send_workers_compress (ENetHost *, const ENetCompressor *);
 extern   void       enet_host_bandwidth_throttle (ENetHost *);
 extern  enet_uint32 enet_host_random_seed (void);
+extern ENetReceiveBuffer * enet_host_acquire_receive_buffer (ENetHost *, size_t);
+extern void        enet_host_release_receive_buffer (ENetReceiveBuffer *);
 
 ENET_API int                 enet_peer_send (ENetPeer *, enet_uint8, ENetPacket *);
+ENET_API int                 enet_peer_submit (ENetPeer *, enet_uint8, ENetPacket *);
 ENET_API ENetPacket *        enet_peer_receive (ENetPeer *, enet_uint8 * channelID);
 ENET_API void                enet_peer_ping (ENetPeer *);
 ENET_API void                enet_peer_ping_interval (ENetPeer *, enet_uint32);
 ENET_API void                enet_peer_timeout (ENetPeer *, enet_uint32, enet_uint32, enet_uint32);
+ENET_API void                enet_peer_acknowledgement_delay (ENetPeer *, enet_uint32, enet_uint32);
+ENET_API void                enet_peer_fast_retransmit (ENetPeer *, enet_uint32);
+ENET_API void                enet_peer_pacing (ENetPeer *, int);
 ENET_API void                enet_peer_reset (ENetPeer *);
 ENET_API void                enet_peer_disconnect (ENetPeer *, enet_uint32);
 ENET_API void                enet_peer_disconnect_now (ENetPeer *, enet_uint32);
@@ -571,6 +932,8 @@ ENET_API void                enet_peer_throttle_configure (ENetPeer *, enet_uint
 extern int                   enet_peer_throttle (ENetPeer *, enet_uint32);
 extern void                  enet_peer_reset_queues (ENetPeer *);
 extern void                  enet_peer_setup_outgoing_command (ENetPeer *, ENetOutgoingCommand *);
+extern void                  enet_peer_free_outgoing_command (ENetPeer *, ENetOutgoingCommand *);
+extern ENetOutgoingCommand * enet_peer_stream_next_fragment (ENetPeer *, ENetOutgoingCommand *);
 extern ENetOutgoingCommand * enet_peer_queue_outgoing_command (ENetPeer *, const ENetProtocol *, ENetPacket *, enet_uint32, enet_uint16);
 extern ENetIncomingCommand * enet_peer_queue_incoming_command (ENetPeer *, const ENetProtocol *, const void *, size_t, enet_uint32, enet_uint32);
 extern ENetAcknowledgement * enet_peer_queue_acknowledgement (ENetPeer *, const ENetProtocol *, enet_uint16);
@@ -578,13 +941,27 @@ extern void                  enet_peer_dispatch_incoming_unreliable_commands (EN
 extern void                  enet_peer_dispatch_incoming_reliable_commands (ENetPeer *, ENetChannel *);
 extern void                  enet_peer_on_connect (ENetPeer *);
 extern void                  enet_peer_on_disconnect (ENetPeer *);
+extern void                  enet_peer_index_sent_reliable_command (ENetPeer *, ENetOutgoingCommand *);
+extern ENetOutgoingCommand * enet_peer_find_sent_reliable_command (ENetPeer *, enet_uint16, enet_uint8);
+extern void                  enet_peer_unindex_sent_reliable_command (ENetPeer *, ENetOutgoingCommand *);
+extern ENetIncomingCommand * enet_peer_find_incoming_reliable_command (ENetChannel *, enet_uint16);
+extern void                  enet_peer_activate (ENetPeer *);
+extern void                  enet_peer_deactivate (ENetPeer *);
 
 ENET_API void * enet_range_coder_create (void);
 ENET_API void   enet_range_coder_destroy (void *);
 ENET_API size_t enet_range_coder_compress (void *, const ENetBuffer *, size_t, size_t, enet_uint8 *, size_t);
 ENET_API size_t enet_range_coder_decompress (void *, const enet_uint8 *, size_t, enet_uint8 *, size_t);
+ENET_API void * enet_range_coder_duplicate (void *);
    
 extern size_t enet_protocol_command_size (enet_uint8);
+extern void   enet_protocol_finish_datagrams (ENetHost *, void *);
+
+extern void   enet_pool_initialize (ENetPool *, size_t, size_t, size_t);
+extern void   enet_pool_destroy (ENetPool *);
+extern void   enet_pool_trim (ENetPool *);
+extern void * enet_pool_allocate (ENetPool *);
+extern void   enet_pool_free (ENetPool *, void *);
 
 #ifdef __cplusplus
 }
@@ -35,7 +35,8 @@ typedef enum _ENetProtocolCommand
    ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT    = 10,
    ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE = 11,
    ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT = 12,
-   ENET_PROTOCOL_COMMAND_COUNT              = 13,
+   ENET_PROTOCOL_COMMAND_ACKNOWLEDGE_RANGE  = 13,
+   ENET_PROTOCOL_COMMAND_COUNT              = 14,
 
    ENET_PROTOCOL_COMMAND_MASK               = 0x0F
 } ENetProtocolCommand;
@@ -44,6 +45,7 @@ typedef enum _ENetProtocolFlag
 {
    ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE = (1 << 7),
    ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED = (1 << 6),
+   ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE_RANGES = (1 << 5),
 
    ENET_PROTOCOL_HEADER_FLAG_COMPRESSED = (1 << 14),
    ENET_PROTOCOL_HEADER_FLAG_SENT_TIME  = (1 << 15),
@@ -82,6 +84,18 @@ typedef struct _ENetProtocolAcknowledge
    enet_uint16 receivedSentTime;
 } ENET_PACKED ENetProtocolAcknowledge;
 
+/** Acknowledges receivedReliableSequenceNumber and, for each bit i set in receivedMask,
+    receivedReliableSequenceNumber + 1 + i on the same channel.  Only sent to peers that
+    set ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE_RANGES on their connect or verify connect command.
+ */
+typedef struct _ENetProtocolAcknowledgeRange
+{
+   ENetProtocolCommandHeader header;
+   enet_uint16 receivedReliableSequenceNumber;
+   enet_uint16 receivedSentTime;
+   enet_uint32 receivedMask;
+} ENET_PACKED ENetProtocolAcknowledgeRange;
+
 typedef struct _ENetProtocolConnect
 {
    ENetProtocolCommandHeader header;
@@ -178,6 +192,7 @@ typedef union _ENetProtocol
 {
    ENetProtocolCommandHeader header;
    ENetProtocolAcknowledge acknowledge;
+   ENetProtocolAcknowledgeRange acknowledgeRange;
    ENetProtocolConnect connect;
    ENetProtocolVerifyConnect verifyConnect;
    ENetProtocolDisconnect disconnect;
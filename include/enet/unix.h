@@ -11,6 +11,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #ifdef MSG_MAXIOVLEN
 #define ENET_BUFFER_MAXIMUM MSG_MAXIOVLEN
@@ -20,6 +21,27 @@ typedef int ENetSocket;
 
 #define ENET_SOCKET_NULL -1
 
+typedef pthread_mutex_t ENetMutex;
+typedef pthread_t ENetThread;
+
+typedef struct _ENetSemaphore
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  condition;
+    unsigned int    count;
+} ENetSemaphore;
+
+/* Atomic operations on size_t values.  Loads acquire, stores release, and the
+   read-modify-write operations are sequentially consistent.  Compare-exchange
+   returns the previous value, which equals the expected value on success. */
+#define ENET_ATOMIC_LOAD(pointer) __atomic_load_n ((pointer), __ATOMIC_ACQUIRE)
+#define ENET_ATOMIC_STORE(pointer, value) __atomic_store_n ((pointer), (value), __ATOMIC_RELEASE)
+#define ENET_ATOMIC_EXCHANGE(pointer, value) __atomic_exchange_n ((pointer), (value), __ATOMIC_SEQ_CST)
+#define ENET_ATOMIC_COMPARE_EXCHANGE(pointer, expected, desired) __sync_val_compare_and_swap ((pointer), (expected), (desired))
+#define ENET_ATOMIC_ADD(pointer, value) __atomic_add_fetch ((pointer), (value), __ATOMIC_SEQ_CST)
+#define ENET_ATOMIC_INCREMENT(pointer) __atomic_add_fetch ((pointer), 1, __ATOMIC_SEQ_CST)
+#define ENET_ATOMIC_DECREMENT(pointer) __atomic_sub_fetch ((pointer), 1, __ATOMIC_SEQ_CST)
+
 #define ENET_HOST_TO_NET_16(value) (htons (value)) /**< macro that converts host to net byte-order of a 16-bit value */
 #define ENET_HOST_TO_NET_32(value) (htonl (value)) /**< macro that converts host to net byte-order of a 32-bit value */
 
@@ -21,6 +21,28 @@ typedef SOCKET ENetSocket;
 
 #define ENET_SOCKET_NULL INVALID_SOCKET
 
+typedef CRITICAL_SECTION ENetMutex;
+typedef HANDLE ENetThread;
+typedef HANDLE ENetSemaphore;
+
+#ifdef _WIN64
+#define ENET_ATOMIC_LOAD(pointer) ((size_t) InterlockedCompareExchange64 ((volatile LONGLONG *) (pointer), 0, 0))
+#define ENET_ATOMIC_STORE(pointer, value) ((void) InterlockedExchange64 ((volatile LONGLONG *) (pointer), (LONGLONG) (value)))
+#define ENET_ATOMIC_EXCHANGE(pointer, value) ((size_t) InterlockedExchange64 ((volatile LONGLONG *) (pointer), (LONGLONG) (value)))
+#define ENET_ATOMIC_COMPARE_EXCHANGE(pointer, expected, desired) ((size_t) InterlockedCompareExchange64 ((volatile LONGLONG *) (pointer), (LONGLONG) (desired), (LONGLONG) (expected)))
+#define ENET_ATOMIC_ADD(pointer, value) ((size_t) InterlockedExchangeAdd64 ((volatile LONGLONG *) (pointer), (LONGLONG) (value)) + (value))
+#define ENET_ATOMIC_INCREMENT(pointer) ((size_t) InterlockedIncrement64 ((volatile LONGLONG *) (pointer)))
+#define ENET_ATOMIC_DECREMENT(pointer) ((size_t) InterlockedDecrement64 ((volatile LONGLONG *) (pointer)))
+#else
+#define ENET_ATOMIC_LOAD(pointer) ((size_t) InterlockedCompareExchange ((volatile LONG *) (pointer), 0, 0))
+#define ENET_ATOMIC_STORE(pointer, value) ((void) InterlockedExchange ((volatile LONG *) (pointer), (LONG) (value)))
+#define ENET_ATOMIC_EXCHANGE(pointer, value) ((size_t) InterlockedExchange ((volatile LONG *) (pointer), (LONG) (value)))
+#define ENET_ATOMIC_COMPARE_EXCHANGE(pointer, expected, desired) ((size_t) InterlockedCompareExchange ((volatile LONG *) (pointer), (LONG) (desired), (LONG) (expected)))
+#define ENET_ATOMIC_ADD(pointer, value) ((size_t) InterlockedExchangeAdd ((volatile LONG *) (pointer), (LONG) (value)) + (value))
+#define ENET_ATOMIC_INCREMENT(pointer) ((size_t) InterlockedIncrement ((volatile LONG *) (pointer)))
+#define ENET_ATOMIC_DECREMENT(pointer) ((size_t) InterlockedDecrement ((volatile LONG *) (pointer)))
+#endif
+
 #define ENET_HOST_TO_NET_16(value) (htons (value))
 #define ENET_HOST_TO_NET_32(value) (htonl (value))
 
@@ -10,35 +10,73 @@
     @{ 
 */
 
+/** Returns the storage that immediately follows the packet header within the
+    packet's own allocation.
+*/
+#define ENET_PACKET_INLINE_DATA(packet) ((enet_uint8 *) ((ENetPacket *) (packet) + 1))
+
 /** Creates a packet that may be sent to a peer.
     @param data         initial contents of the packet's data; the packet's data will remain uninitialized if data is NULL.
     @param dataLength   size of the data allocated for this packet
     @param flags        flags for this packet as described for the ENetPacket structure.
     @returns the packet on success, NULL on failure
+    @remarks Unless ENET_PACKET_FLAG_NO_ALLOCATE is specified, the packet's data is stored in the
+    same allocation as the packet itself.
 */
 ENetPacket *
 enet_packet_create (const void * data, size_t dataLength, enet_uint32 flags)
 {
-    ENetPacket * packet = (ENetPacket *) enet_malloc (sizeof (ENetPacket));
-    if (packet == NULL)
-      return NULL;
+    return enet_packet_create_with_capacity (data, dataLength, dataLength, 0, flags);
+}
+
+/** Creates a packet with room for its data to grow or to be prefixed without reallocation.
+    @param data         initial contents of the packet's data; the packet's data will remain uninitialized if data is NULL.
+    @param dataLength   initial length of the packet's data
+    @param capacity     number of bytes reserved for the packet's data, at least dataLength
+    @param headroom     number of bytes reserved in front of the packet's data for enet_packet_prepend()
+    @param flags        flags for this packet as described for the ENetPacket structure.
+    @returns the packet on success, NULL on failure
+    @remarks capacity and headroom are ignored if ENET_PACKET_FLAG_NO_ALLOCATE is specified.
+    @sa enet_packet_resize()
+    @sa enet_packet_prepend()
+*/
+ENetPacket *
+enet_packet_create_with_capacity (const void * data, size_t dataLength, size_t capacity, size_t headroom, enet_uint32 flags)
+{
+    ENetPacket * packet;
 
     if (flags & ENET_PACKET_FLAG_NO_ALLOCATE)
-      packet -> data = (enet_uint8 *) data;
-    else
-    if (dataLength <= 0)
-      packet -> data = NULL;
+    {
+       packet = (ENetPacket *) enet_malloc (sizeof (ENetPacket));
+       if (packet == NULL)
+         return NULL;
+
+       packet -> data = (enet_uint8 *) data;
+
+       capacity = dataLength;
+       headroom = 0;
+    }
     else
     {
-       packet -> data = (enet_uint8 *) enet_malloc (dataLength);
-       if (packet -> data == NULL)
+       if (capacity < dataLength)
+         capacity = dataLength;
+
+       if (capacity > ~ (size_t) 0 - sizeof (ENetPacket) - headroom)
+         return NULL;
+
+       packet = (ENetPacket *) enet_malloc (sizeof (ENetPacket) + headroom + capacity);
+       if (packet == NULL)
+         return NULL;
+
+       if (headroom + capacity <= 0)
+         packet -> data = NULL;
+       else
        {
-          enet_free (packet);
-          return NULL;
-       }
+          packet -> data = ENET_PACKET_INLINE_DATA (packet) + headroom;
 
-       if (data != NULL)
-         memcpy (packet -> data, data, dataLength);
+          if (data != NULL && dataLength > 0)
+            memcpy (packet -> data, data, dataLength);
+       }
     }
 
     packet -> referenceCount = 0;
@@ -46,10 +84,183 @@ enet_packet_create (const void * data, size_t dataLength, enet_uint32 flags)
     packet -> dataLength = dataLength;
     packet -> freeCallback = NULL;
     packet -> userData = NULL;
+    packet -> receiveBuffer = NULL;
+    packet -> segments = NULL;
+    packet -> segmentCount = 0;
+    packet -> capacity = capacity;
+    packet -> headroom = headroom;
 
     return packet;
 }
 
+/** Creates a packet whose data is gathered from several buffers.
+    @param buffers      buffers holding the contents of the packet's data, in order
+    @param bufferCount  number of buffers
+    @param flags        flags for this packet as described for the ENetPacket structure.
+    @returns the packet on success, NULL on failure
+    @remarks Unless ENET_PACKET_FLAG_NO_ALLOCATE is specified, the buffers are copied into the
+    packet's data.  With ENET_PACKET_FLAG_NO_ALLOCATE, the packet refers to the buffers' memory
+    directly, which must then remain valid until the packet is destroyed, and is sent without
+    being flattened; the packet's data field is NULL if more than one buffer is given, and at
+    most ENET_PACKET_SEGMENT_MAXIMUM buffers may be given.
+*/
+ENetPacket *
+enet_packet_create_from_buffers (const ENetBuffer * buffers, size_t bufferCount, enet_uint32 flags)
+{
+    ENetPacket * packet;
+    size_t dataLength = 0, i;
+
+    for (i = 0; i < bufferCount; ++ i)
+      dataLength += buffers [i].dataLength;
+
+    if (flags & ENET_PACKET_FLAG_NO_ALLOCATE)
+    {
+       if (bufferCount <= 1)
+         return enet_packet_create (bufferCount > 0 ? buffers [0].data : NULL, dataLength, flags);
+
+       if (bufferCount > ENET_PACKET_SEGMENT_MAXIMUM)
+         return NULL;
+
+       packet = (ENetPacket *) enet_malloc (sizeof (ENetPacket) + bufferCount * sizeof (ENetBuffer));
+       if (packet == NULL)
+         return NULL;
+
+       packet -> referenceCount = 0;
+       packet -> flags = flags;
+       packet -> data = NULL;
+       packet -> dataLength = dataLength;
+       packet -> freeCallback = NULL;
+       packet -> userData = NULL;
+       packet -> receiveBuffer = NULL;
+       packet -> segments = (ENetBuffer *) (packet + 1);
+       packet -> segmentCount = bufferCount;
+       packet -> capacity = dataLength;
+       packet -> headroom = 0;
+
+       memcpy (packet -> segments, buffers, bufferCount * sizeof (ENetBuffer));
+
+       return packet;
+    }
+
+    packet = enet_packet_create (NULL, dataLength, flags);
+    if (packet == NULL)
+      return NULL;
+
+    for (i = 0, dataLength = 0; i < bufferCount; ++ i)
+    {
+       if (buffers [i].dataLength <= 0)
+         continue;
+
+       memcpy (packet -> data + dataLength, buffers [i].data, buffers [i].dataLength);
+
+       dataLength += buffers [i].dataLength;
+    }
+
+    return packet;
+}
+
+/** Describes part of a packet's data as a list of buffers, without copying it.
+    @param packet       packet to describe
+    @param offset       offset of the first byte to describe
+    @param length       number of bytes to describe
+    @param buffers      buffers to fill
+    @param bufferLimit  maximum number of buffers that may be filled
+    @returns the number of buffers filled, or 0 if more than bufferLimit buffers are needed
+*/
+size_t
+enet_packet_gather (const ENetPacket * packet, size_t offset, size_t length, ENetBuffer * buffers, size_t bufferLimit)
+{
+    const ENetBuffer * segment, * segmentEnd;
+    size_t bufferCount = 0;
+
+    if (packet -> segments == NULL || length <= 0)
+    {
+       buffers -> data = packet -> data != NULL ? packet -> data + offset : NULL;
+       buffers -> dataLength = length;
+
+       return 1;
+    }
+
+    segment = packet -> segments;
+    segmentEnd = & packet -> segments [packet -> segmentCount];
+
+    for (; segment < segmentEnd && offset >= segment -> dataLength; ++ segment)
+      offset -= segment -> dataLength;
+
+    for (; segment < segmentEnd && length > 0; ++ segment)
+    {
+       size_t segmentLength = segment -> dataLength - offset;
+
+       if (segmentLength > length)
+         segmentLength = length;
+
+       if (segmentLength > 0)
+       {
+          if (bufferCount >= bufferLimit)
+            return 0;
+
+          buffers [bufferCount].data = (enet_uint8 *) segment -> data + offset;
+          buffers [bufferCount].dataLength = segmentLength;
+
+          ++ bufferCount;
+
+          length -= segmentLength;
+       }
+
+       offset = 0;
+    }
+
+    return bufferCount;
+}
+
+/** Creates a packet whose data refers in place to part of a receive buffer.
+    @param buffer       receive buffer holding the packet's data
+    @param data         start of the packet's data within the buffer
+    @param dataLength   length of the packet's data
+    @param flags        flags for this packet as described for the ENetPacket structure.
+    @returns the packet on success, NULL on failure
+    @remarks The packet holds a reference to the buffer until it is destroyed or grown with enet_packet_resize().
+*/
+ENetPacket *
+enet_packet_create_from_receive_buffer (ENetReceiveBuffer * buffer, const void * data, size_t dataLength, enet_uint32 flags)
+{
+    ENetPacket * packet = (ENetPacket *) enet_malloc (sizeof (ENetPacket));
+    if (packet == NULL)
+      return NULL;
+
+    packet -> referenceCount = 0;
+    packet -> flags = flags & ~ ENET_PACKET_FLAG_NO_ALLOCATE;
+    packet -> data = (enet_uint8 *) data;
+    packet -> dataLength = dataLength;
+    packet -> freeCallback = NULL;
+    packet -> userData = NULL;
+    packet -> receiveBuffer = buffer;
+    packet -> segments = NULL;
+    packet -> segmentCount = 0;
+    packet -> capacity = dataLength;
+    packet -> headroom = 0;
+
+    ++ buffer -> referenceCount;
+
+    return packet;
+}
+
+static void
+enet_packet_release_data (ENetPacket * packet)
+{
+    if (packet -> receiveBuffer != NULL)
+    {
+       enet_host_release_receive_buffer (packet -> receiveBuffer);
+
+       packet -> receiveBuffer = NULL;
+    }
+    else
+    if (! (packet -> flags & ENET_PACKET_FLAG_NO_ALLOCATE) &&
+        packet -> data != NULL &&
+        packet -> data - packet -> headroom != ENET_PACKET_INLINE_DATA (packet))
+      enet_free (packet -> data - packet -> headroom);
+}
+
 /** Destroys the packet and deallocates its data.
     @param packet packet to be destroyed
 */
@@ -61,43 +272,172 @@ enet_packet_destroy (ENetPacket * packet)
 
     if (packet -> freeCallback != NULL)
       (* packet -> freeCallback) (packet);
-    if (! (packet -> flags & ENET_PACKET_FLAG_NO_ALLOCATE) &&
-        packet -> data != NULL)
-      enet_free (packet -> data);
+    enet_packet_release_data (packet);
     enet_free (packet);
 }
 
+/** Adds references to a packet, atomically if it is ENET_PACKET_FLAG_SHARED. */
+void
+enet_packet_add_references (ENetPacket * packet, size_t count)
+{
+    if (packet -> flags & ENET_PACKET_FLAG_SHARED)
+      ENET_ATOMIC_ADD (& packet -> referenceCount, count);
+    else
+      packet -> referenceCount += count;
+}
+
+/** Drops a reference to a packet, atomically if it is ENET_PACKET_FLAG_SHARED.
+    @returns the number of references left, which only the caller that dropped the last one sees as 0
+*/
+size_t
+enet_packet_remove_reference (ENetPacket * packet)
+{
+    if (packet -> flags & ENET_PACKET_FLAG_SHARED)
+      return ENET_ATOMIC_DECREMENT (& packet -> referenceCount);
+
+    return -- packet -> referenceCount;
+}
+
+/** Holds a reference to a packet on behalf of the application, keeping it from being destroyed
+    when the hosts it is queued on are done with it.
+    @param packet packet to hold
+
+    @remarks A packet created with ENET_PACKET_FLAG_SHARED may be queued on several hosts that are
+    serviced by different threads, for example with enet_peer_submit() or
+    enet_host_group_broadcast(), and is destroyed exactly once, by whichever host or thread drops
+    the last reference to it.  An application handing such a packet to more than one host should
+    hold a reference while doing so, and drop it with enet_packet_release() afterwards, so that
+    the first host cannot destroy the packet before it reaches the others.  A packet delivered
+    with enet_host_receive_zero_copy() is first copied out of its receive buffer, so it must be
+    retained on the thread that received it.
+*/
+void
+enet_packet_retain (ENetPacket * packet)
+{
+    enet_packet_detach_receive_buffer (packet);
+
+    enet_packet_add_references (packet, 1);
+}
+
+/** Drops a reference held with enet_packet_retain(), destroying the packet if no host holds it.
+    @param packet packet to release
+*/
+void
+enet_packet_release (ENetPacket * packet)
+{
+    if (enet_packet_remove_reference (packet) == 0)
+      enet_packet_destroy (packet);
+}
+
+static int
+enet_packet_reallocate (ENetPacket * packet, size_t headroom, size_t capacity)
+{
+    enet_uint8 * newData;
+
+    if (capacity > ~ (size_t) 0 - headroom)
+      return -1;
+
+    newData = (enet_uint8 *) enet_malloc (headroom + capacity);
+    if (newData == NULL)
+      return -1;
+
+    if (packet -> dataLength > 0)
+      memcpy (newData + headroom, packet -> data, packet -> dataLength);
+
+    enet_packet_release_data (packet);
+
+    packet -> data = newData + headroom;
+    packet -> capacity = capacity;
+    packet -> headroom = headroom;
+
+    return 0;
+}
+
+/** Copies the data of a packet that refers in place to a receive buffer into its own allocation,
+    so that the packet no longer holds the buffer.  Receive buffers are recycled by the host that
+    received into them without any locking, so a packet must be detached on that host's thread
+    before it is handed to another.
+    @returns 0 on success, < 0 on failure
+*/
+int
+enet_packet_detach_receive_buffer (ENetPacket * packet)
+{
+    if (packet -> receiveBuffer == NULL)
+      return 0;
+
+    return enet_packet_reallocate (packet, packet -> headroom, packet -> capacity);
+}
+
 /** Attempts to resize the data in the packet to length specified in the 
     dataLength parameter 
     @param packet packet to resize
     @param dataLength new size for the packet data
     @returns 0 on success, < 0 on failure
+    @remarks Growing a packet beyond its capacity at least doubles the capacity, so that data
+    may be appended to a packet in amortized constant time.
 */
 int
 enet_packet_resize (ENetPacket * packet, size_t dataLength)
 {
-    enet_uint8 * newData;
-   
-    if (dataLength <= packet -> dataLength || (packet -> flags & ENET_PACKET_FLAG_NO_ALLOCATE))
+    size_t capacity;
+
+    if (dataLength <= packet -> capacity || (packet -> flags & ENET_PACKET_FLAG_NO_ALLOCATE))
     {
        packet -> dataLength = dataLength;
 
        return 0;
     }
 
-    newData = (enet_uint8 *) enet_malloc (dataLength);
-    if (newData == NULL)
+    capacity = packet -> capacity <= ~ (size_t) 0 / 2 ? packet -> capacity * 2 : dataLength;
+    if (capacity < dataLength)
+      capacity = dataLength;
+
+    if (enet_packet_reallocate (packet, packet -> headroom, capacity) < 0)
       return -1;
 
-    memcpy (newData, packet -> data, packet -> dataLength);
-    enet_free (packet -> data);
-    
-    packet -> data = newData;
     packet -> dataLength = dataLength;
 
     return 0;
 }
 
+/** Inserts data in front of the data already in the packet.
+    @param packet packet to prefix
+    @param data contents to insert; the inserted bytes remain uninitialized if data is NULL
+    @param dataLength number of bytes to insert
+    @returns 0 on success, < 0 on failure
+    @remarks The data is inserted without copying the packet's existing data if the packet
+    was created with enough headroom by enet_packet_create_with_capacity().  Otherwise the
+    headroom is grown to leave as much spare room in front of the data as the packet already
+    holds, so that a stack of headers may be prepended in amortized constant time.  Packets
+    created with ENET_PACKET_FLAG_NO_ALLOCATE cannot be prefixed.
+*/
+int
+enet_packet_prepend (ENetPacket * packet, const void * data, size_t dataLength)
+{
+    if (packet -> flags & ENET_PACKET_FLAG_NO_ALLOCATE)
+      return -1;
+
+    if (dataLength <= 0)
+      return 0;
+
+    if (dataLength > packet -> headroom)
+    {
+       if (packet -> dataLength > ~ (size_t) 0 - dataLength ||
+           enet_packet_reallocate (packet, dataLength + packet -> dataLength, packet -> capacity > packet -> dataLength ? packet -> capacity : packet -> dataLength) < 0)
+         return -1;
+    }
+
+    packet -> data -= dataLength;
+    packet -> headroom -= dataLength;
+    packet -> capacity += dataLength;
+    packet -> dataLength += dataLength;
+
+    if (data != NULL && dataLength > 0)
+      memcpy (packet -> data, data, dataLength);
+
+    return 0;
+}
+
 static int initializedCRC32 = 0;
 static enet_uint32 crcTable [256];
 
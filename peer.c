@@ -6,6 +6,9 @@
 #define ENET_BUILDING_LIB 1
 #include "enet/enet.h"
 
+#define ENET_PEER_RELIABLE_INDEX_BLOCKS \
+    ((ENET_PEER_RELIABLE_WINDOWS * ENET_PEER_RELIABLE_WINDOW_SIZE) / ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE)
+
 /** @defgroup peer ENet peer functions 
     @{
 */
@@ -89,6 +92,16 @@ enet_peer_throttle (ENetPeer * peer, enet_uint32 rtt)
     return 0;
 }
 
+static void
+enet_peer_describe_fragment (ENetOutgoingCommand * fragment, enet_uint32 fragmentNumber, enet_uint32 fragmentOffset, enet_uint16 fragmentLength)
+{
+   fragment -> fragmentOffset = fragmentOffset;
+   fragment -> fragmentLength = fragmentLength;
+   fragment -> command.sendFragment.dataLength = ENET_HOST_TO_NET_16 (fragmentLength);
+   fragment -> command.sendFragment.fragmentNumber = ENET_HOST_TO_NET_32 (fragmentNumber);
+   fragment -> command.sendFragment.fragmentOffset = ENET_HOST_TO_NET_32 (fragmentOffset);
+}
+
 /** Queues a packet to be sent.
     @param peer destination for the packet
     @param channelID channel on which to send
@@ -121,6 +134,7 @@ enet_peer_send (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
       enet_uint16 startSequenceNumber; 
       ENetList fragments;
       ENetOutgoingCommand * fragment;
+      ENetOutgoingCommandBlock * block = NULL;
 
       if (fragmentCount > ENET_PROTOCOL_MAXIMUM_FRAGMENT_COUNT)
         return -1;
@@ -137,6 +151,41 @@ enet_peer_send (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
          startSequenceNumber = ENET_HOST_TO_NET_16 (channel -> outgoingReliableSequenceNumber + 1);
       }
         
+      if (commandNumber & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE)
+      {
+         fragment = (ENetOutgoingCommand *) enet_pool_allocate (& peer -> host -> outgoingCommandPool);
+         if (fragment == NULL)
+           return -1;
+
+         fragment -> block = NULL;
+         fragment -> streamFragments = fragmentCount;
+         fragment -> packet = packet;
+         fragment -> command.header.command = commandNumber;
+         fragment -> command.header.channelID = channelID;
+         fragment -> command.sendFragment.startSequenceNumber = startSequenceNumber;
+         fragment -> command.sendFragment.fragmentCount = ENET_HOST_TO_NET_32 (fragmentCount);
+         fragment -> command.sendFragment.totalLength = ENET_HOST_TO_NET_32 (packet -> dataLength);
+         enet_peer_describe_fragment (fragment, 0, 0, fragmentLength);
+
+         enet_packet_add_references (packet, 1);
+
+         enet_peer_setup_outgoing_command (peer, fragment);
+
+         channel -> outgoingReliableSequenceNumber += fragmentCount - 1;
+         peer -> outgoingDataTotal += (fragmentCount - 1) * enet_protocol_command_size (commandNumber) + packet -> dataLength - fragmentLength;
+
+         return 0;
+      }
+
+      if (fragmentCount > ENET_HOST_POOL_SLAB_SIZE)
+      {
+         block = (ENetOutgoingCommandBlock *) enet_malloc (sizeof (ENetOutgoingCommandBlock) + (fragmentCount - 1) * sizeof (ENetOutgoingCommand));
+         if (block == NULL)
+           return -1;
+
+         block -> referenceCount = fragmentCount;
+      }
+
       enet_list_clear (& fragments);
 
       for (fragmentNumber = 0,
@@ -148,35 +197,36 @@ enet_peer_send (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
          if (packet -> dataLength - fragmentOffset < fragmentLength)
            fragmentLength = packet -> dataLength - fragmentOffset;
 
-         fragment = (ENetOutgoingCommand *) enet_malloc (sizeof (ENetOutgoingCommand));
+         if (block != NULL)
+           fragment = & block -> commands [fragmentNumber];
+         else
+           fragment = (ENetOutgoingCommand *) enet_pool_allocate (& peer -> host -> outgoingCommandPool);
          if (fragment == NULL)
          {
             while (! enet_list_empty (& fragments))
             {
                fragment = (ENetOutgoingCommand *) enet_list_remove (enet_list_begin (& fragments));
                
-               enet_free (fragment);
+               enet_pool_free (& peer -> host -> outgoingCommandPool, fragment);
             }
             
             return -1;
          }
          
-         fragment -> fragmentOffset = fragmentOffset;
-         fragment -> fragmentLength = fragmentLength;
+         fragment -> block = block;
+         fragment -> streamFragments = 0;
          fragment -> packet = packet;
          fragment -> command.header.command = commandNumber;
          fragment -> command.header.channelID = channelID;
          fragment -> command.sendFragment.startSequenceNumber = startSequenceNumber;
-         fragment -> command.sendFragment.dataLength = ENET_HOST_TO_NET_16 (fragmentLength);
          fragment -> command.sendFragment.fragmentCount = ENET_HOST_TO_NET_32 (fragmentCount);
-         fragment -> command.sendFragment.fragmentNumber = ENET_HOST_TO_NET_32 (fragmentNumber);
          fragment -> command.sendFragment.totalLength = ENET_HOST_TO_NET_32 (packet -> dataLength);
-         fragment -> command.sendFragment.fragmentOffset = ENET_NET_TO_HOST_32 (fragmentOffset);
+         enet_peer_describe_fragment (fragment, fragmentNumber, fragmentOffset, fragmentLength);
         
          enet_list_insert (enet_list_end (& fragments), fragment);
       }
 
-      packet -> referenceCount += fragmentNumber;
+      enet_packet_add_references (packet, fragmentNumber);
 
       while (! enet_list_empty (& fragments))
       {
@@ -213,6 +263,84 @@ enet_peer_send (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
    return 0;
 }
 
+/** Queues a packet to be sent from a thread other than the one that services the peer's host.
+    @param peer destination for the packet
+    @param channelID channel on which to send
+    @param packet packet to send
+    @retval 0 on success
+    @retval < 0 if the host has no submission queue or it is full
+
+    @remarks The host must have a queue set up with enet_host_submission_queue().  The packet is
+    queued on the peer as by enet_peer_send() at the start of the host's next send pass, and is
+    destroyed then if the peer is no longer connected.  Once submitted, the packet belongs to the
+    host and must not be touched by the caller, unless it is ENET_PACKET_FLAG_SHARED and held
+    with enet_packet_retain(), in which case it may be submitted again.  Packets submitted from
+    one thread are queued in the order they were submitted.  Since a peer may be reset and reused
+    by the service thread at any time, the caller must itself make sure the peer is still the one
+    it means to send to.  A packet delivered with enet_host_receive_zero_copy() is copied out of
+    its receive buffer first, so it must be submitted from the thread that received it.
+*/
+int
+enet_peer_submit (ENetPeer * peer, enet_uint8 channelID, ENetPacket * packet)
+{
+   ENetHost * host = peer -> host;
+   ENetSubmission * submission;
+   size_t position;
+
+   if (host -> submissions == NULL ||
+       enet_packet_detach_receive_buffer (packet) < 0)
+     return -1;
+
+   position = ENET_ATOMIC_LOAD (& host -> submissionHead);
+
+   for (;;)
+   {
+      size_t sequence;
+
+      submission = & host -> submissions [position & host -> submissionMask];
+      sequence = ENET_ATOMIC_LOAD (& submission -> sequence);
+
+      if (sequence == position)
+      {
+         size_t previous = ENET_ATOMIC_COMPARE_EXCHANGE (& host -> submissionHead, position, position + 1);
+
+         if (previous == position)
+           break;
+
+         position = previous;
+      }
+      else
+      if (sequence == position - host -> submissionMask)
+        return -1;
+      else
+        position = ENET_ATOMIC_LOAD (& host -> submissionHead);
+   }
+
+   enet_packet_add_references (packet, 1);
+
+   submission -> peer = peer;
+   submission -> channelID = channelID;
+   submission -> packet = packet;
+
+   ENET_ATOMIC_STORE (& submission -> sequence, position + 1);
+
+   if (host -> submissionWakeup != ENET_SOCKET_NULL &&
+       ENET_ATOMIC_EXCHANGE (& host -> submissionWakeupPending, 1) == 0)
+     enet_socket_signal_wakeup (host -> submissionWakeup);
+
+   return 0;
+}
+
+/** Returns how much of the host's maximum waiting data an incoming packet takes up.  A packet
+    that refers to a receive buffer in place keeps the whole buffer allocated, so it is charged
+    the size of the buffer rather than of its own data.
+*/
+static size_t
+enet_peer_waiting_data_size (const ENetPacket * packet)
+{
+   return packet -> receiveBuffer != NULL ? packet -> receiveBuffer -> dataLength : packet -> dataLength;
+}
+
 /** Attempts to dequeue any incoming queued packet.
     @param peer peer to dequeue packets from
     @param channelID holds the channel ID of the channel the packet was received on success
@@ -239,15 +367,84 @@ enet_peer_receive (ENetPeer * peer, enet_uint8 * channelID)
    if (incomingCommand -> fragments != NULL)
      enet_free (incomingCommand -> fragments);
 
-   enet_free (incomingCommand);
+   enet_pool_free (& peer -> host -> incomingCommandPool, incomingCommand);
 
-   peer -> totalWaitingData -= packet -> dataLength;
+   peer -> totalWaitingData -= enet_peer_waiting_data_size (packet);
 
    return packet;
 }
 
+/** Releases an outgoing command once it is no longer queued or in transit.
+    Commands carved from a fragment block only drop a reference to it; the block
+    itself is freed along with its last command.
+*/
+void
+enet_peer_free_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoingCommand)
+{
+    ENetOutgoingCommandBlock * block = outgoingCommand -> block;
+
+    if (block == NULL)
+    {
+       enet_pool_free (& peer -> host -> outgoingCommandPool, outgoingCommand);
+
+       return;
+    }
+
+    if (-- block -> referenceCount == 0)
+      enet_free (block);
+}
+
+/** Emits the next fragment of a streaming command ahead of it in the outgoing reliable queue.
+    The streaming command advances to describe the following fragment, and is released
+    once its last fragment has been emitted.
+    @returns the emitted fragment, or NULL if it could not be allocated
+*/
+ENetOutgoingCommand *
+enet_peer_stream_next_fragment (ENetPeer * peer, ENetOutgoingCommand * streamCommand)
+{
+    ENetOutgoingCommand * fragment = (ENetOutgoingCommand *) enet_pool_allocate (& peer -> host -> outgoingCommandPool);
+    enet_uint32 fragmentOffset;
+    enet_uint16 fragmentLength;
+
+    if (fragment == NULL)
+      return NULL;
+
+    * fragment = * streamCommand;
+    fragment -> streamFragments = 0;
+
+    enet_packet_add_references (fragment -> packet, 1);
+
+    enet_list_insert (& streamCommand -> outgoingCommandList, fragment);
+
+    if (-- streamCommand -> streamFragments == 0)
+    {
+       enet_list_remove (& streamCommand -> outgoingCommandList);
+
+       enet_packet_remove_reference (streamCommand -> packet);
+
+       enet_peer_free_outgoing_command (peer, streamCommand);
+
+       return fragment;
+    }
+
+    fragmentOffset = streamCommand -> fragmentOffset + streamCommand -> fragmentLength;
+    fragmentLength = streamCommand -> fragmentLength;
+    if (streamCommand -> packet -> dataLength - fragmentOffset < fragmentLength)
+      fragmentLength = streamCommand -> packet -> dataLength - fragmentOffset;
+
+    ++ streamCommand -> reliableSequenceNumber;
+    streamCommand -> command.header.reliableSequenceNumber = ENET_HOST_TO_NET_16 (streamCommand -> reliableSequenceNumber);
+
+    enet_peer_describe_fragment (streamCommand,
+                                 ENET_NET_TO_HOST_32 (streamCommand -> command.sendFragment.fragmentNumber) + 1,
+                                 fragmentOffset,
+                                 fragmentLength);
+
+    return fragment;
+}
+
 static void
-enet_peer_reset_outgoing_commands (ENetList * queue)
+enet_peer_reset_outgoing_commands (ENetPeer * peer, ENetList * queue)
 {
     ENetOutgoingCommand * outgoingCommand;
 
@@ -257,18 +454,16 @@ enet_peer_reset_outgoing_commands (ENetList * queue)
 
        if (outgoingCommand -> packet != NULL)
        {
-          -- outgoingCommand -> packet -> referenceCount;
-
-          if (outgoingCommand -> packet -> referenceCount == 0)
+          if (enet_packet_remove_reference (outgoingCommand -> packet) == 0)
             enet_packet_destroy (outgoingCommand -> packet);
        }
 
-       enet_free (outgoingCommand);
+       enet_peer_free_outgoing_command (peer, outgoingCommand);
     }
 }
 
 static void
-enet_peer_remove_incoming_commands (ENetList * queue, ENetListIterator startCommand, ENetListIterator endCommand)
+enet_peer_remove_incoming_commands (ENetPeer * peer, ENetList * queue, ENetListIterator startCommand, ENetListIterator endCommand)
 {
     ENetListIterator currentCommand;    
     
@@ -291,14 +486,14 @@ enet_peer_remove_incoming_commands (ENetList * queue, ENetListIterator startComm
        if (incomingCommand -> fragments != NULL)
          enet_free (incomingCommand -> fragments);
 
-       enet_free (incomingCommand);
+       enet_pool_free (& peer -> host -> incomingCommandPool, incomingCommand);
     }
 }
 
 static void
-enet_peer_reset_incoming_commands (ENetList * queue)
+enet_peer_reset_incoming_commands (ENetPeer * peer, ENetList * queue)
 {
-    enet_peer_remove_incoming_commands(queue, enet_list_begin (queue), enet_list_end (queue));
+    enet_peer_remove_incoming_commands(peer, queue, enet_list_begin (queue), enet_list_end (queue));
 }
  
 void
@@ -314,13 +509,21 @@ enet_peer_reset_queues (ENetPeer * peer)
     }
 
     while (! enet_list_empty (& peer -> acknowledgements))
-      enet_free (enet_list_remove (enet_list_begin (& peer -> acknowledgements)));
+      enet_pool_free (& peer -> host -> acknowledgementPool, enet_list_remove (enet_list_begin (& peer -> acknowledgements)));
 
-    enet_peer_reset_outgoing_commands (& peer -> sentReliableCommands);
-    enet_peer_reset_outgoing_commands (& peer -> sentUnreliableCommands);
-    enet_peer_reset_outgoing_commands (& peer -> outgoingReliableCommands);
-    enet_peer_reset_outgoing_commands (& peer -> outgoingUnreliableCommands);
-    enet_peer_reset_incoming_commands (& peer -> dispatchedCommands);
+    peer -> acknowledgementCount = 0;
+
+    enet_peer_reset_outgoing_commands (peer, & peer -> sentReliableCommands);
+    enet_peer_reset_outgoing_commands (peer, & peer -> sentUnreliableCommands);
+    enet_peer_reset_outgoing_commands (peer, & peer -> outgoingReliableCommands);
+    enet_peer_reset_outgoing_commands (peer, & peer -> outgoingUnreliableCommands);
+    enet_peer_reset_incoming_commands (peer, & peer -> dispatchedCommands);
+
+    if (peer -> sentReliableIndex != NULL)
+      memset (peer -> sentReliableIndex, 0, peer -> sentReliableIndexSize * sizeof (ENetOutgoingCommand *));
+
+    peer -> sentReliableIndexCount = 0;
+    peer -> sentReliableUnindexed = 0;
 
     if (peer -> channels != NULL && peer -> channelCount > 0)
     {
@@ -328,8 +531,21 @@ enet_peer_reset_queues (ENetPeer * peer)
              channel < & peer -> channels [peer -> channelCount];
              ++ channel)
         {
-            enet_peer_reset_incoming_commands (& channel -> incomingReliableCommands);
-            enet_peer_reset_incoming_commands (& channel -> incomingUnreliableCommands);
+            enet_peer_reset_incoming_commands (peer, & channel -> incomingReliableCommands);
+            enet_peer_reset_incoming_commands (peer, & channel -> incomingUnreliableCommands);
+
+            if (channel -> incomingReliableIndex != NULL)
+            {
+                size_t block;
+
+                for (block = 0; block < ENET_PEER_RELIABLE_INDEX_BLOCKS; ++ block)
+                {
+                    if (channel -> incomingReliableIndex [block] != NULL)
+                      enet_free (channel -> incomingReliableIndex [block]);
+                }
+
+                enet_free (channel -> incomingReliableIndex);
+            }
         }
 
         enet_free (peer -> channels);
@@ -348,6 +564,12 @@ enet_peer_on_connect (ENetPeer * peer)
           ++ peer -> host -> bandwidthLimitedPeers;
 
         ++ peer -> host -> connectedPeers;
+
+        if (peer -> host -> congestionControl.onConnect != NULL)
+          (* peer -> host -> congestionControl.onConnect) (peer -> host -> congestionControl.context, peer);
+
+        if (peer -> host -> group != NULL)
+          enet_host_group_count_connected_peer (peer -> host -> group, 1);
     }
 }
 
@@ -360,6 +582,235 @@ enet_peer_on_disconnect (ENetPeer * peer)
           -- peer -> host -> bandwidthLimitedPeers;
 
         -- peer -> host -> connectedPeers;
+
+        if (peer -> host -> group != NULL)
+          enet_host_group_count_connected_peer (peer -> host -> group, 0);
+
+        if (peer -> host -> congestionControl.onDisconnect != NULL)
+          (* peer -> host -> congestionControl.onDisconnect) (peer -> host -> congestionControl.context, peer);
+
+        peer -> congestionWindow = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+        peer -> pacingRate = 0;
+    }
+}
+
+#define ENET_PEER_SENT_RELIABLE_BUCKET(peer, reliableSequenceNumber, channelID) \
+    (((size_t) (reliableSequenceNumber) + (size_t) (channelID) * 0x9E37) & ((peer) -> sentReliableIndexSize - 1))
+
+static int
+enet_peer_grow_sent_reliable_index (ENetPeer * peer)
+{
+    size_t newSize = peer -> sentReliableIndexSize ? peer -> sentReliableIndexSize * 2 : ENET_PEER_SENT_RELIABLE_INDEX_SIZE,
+           oldSize = peer -> sentReliableIndexSize,
+           i;
+    ENetOutgoingCommand ** oldIndex = peer -> sentReliableIndex,
+                        ** newIndex = (ENetOutgoingCommand **) enet_malloc (newSize * sizeof (ENetOutgoingCommand *));
+
+    if (newIndex == NULL)
+      return -1;
+
+    memset (newIndex, 0, newSize * sizeof (ENetOutgoingCommand *));
+
+    peer -> sentReliableIndex = newIndex;
+    peer -> sentReliableIndexSize = newSize;
+
+    for (i = 0; i < oldSize; ++ i)
+    {
+       ENetOutgoingCommand * outgoingCommand = oldIndex [i];
+
+       while (outgoingCommand != NULL)
+       {
+          ENetOutgoingCommand * nextCommand = outgoingCommand -> nextIndexedCommand;
+          size_t bucket = ENET_PEER_SENT_RELIABLE_BUCKET (peer, outgoingCommand -> reliableSequenceNumber, outgoingCommand -> command.header.channelID);
+
+          outgoingCommand -> nextIndexedCommand = newIndex [bucket];
+          newIndex [bucket] = outgoingCommand;
+
+          outgoingCommand = nextCommand;
+       }
+    }
+
+    if (oldIndex != NULL)
+      enet_free (oldIndex);
+
+    return 0;
+}
+
+void
+enet_peer_index_sent_reliable_command (ENetPeer * peer, ENetOutgoingCommand * outgoingCommand)
+{
+    size_t bucket;
+
+    if (peer -> sentReliableIndexCount >= peer -> sentReliableIndexSize &&
+        enet_peer_grow_sent_reliable_index (peer) < 0 &&
+        peer -> sentReliableIndex == NULL)
+    {
+       ++ peer -> sentReliableUnindexed;
+
+       return;
+    }
+
+    bucket = ENET_PEER_SENT_RELIABLE_BUCKET (peer, outgoingCommand -> reliableSequenceNumber, outgoingCommand -> command.header.channelID);
+
+    outgoingCommand -> nextIndexedCommand = peer -> sentReliableIndex [bucket];
+    peer -> sentReliableIndex [bucket] = outgoingCommand;
+
+    ++ peer -> sentReliableIndexCount;
+}
+
+ENetOutgoingCommand *
+enet_peer_find_sent_reliable_command (ENetPeer * peer, enet_uint16 reliableSequenceNumber, enet_uint8 channelID)
+{
+    ENetOutgoingCommand * outgoingCommand;
+
+    if (peer -> sentReliableIndex == NULL)
+      return NULL;
+
+    for (outgoingCommand = peer -> sentReliableIndex [ENET_PEER_SENT_RELIABLE_BUCKET (peer, reliableSequenceNumber, channelID)];
+         outgoingCommand != NULL;
+         outgoingCommand = outgoingCommand -> nextIndexedCommand)
+    {
+       if (outgoingCommand -> reliableSequenceNumber == reliableSequenceNumber &&
+           outgoingCommand -> command.header.channelID == channelID)
+         return outgoingCommand;
+    }
+
+    return NULL;
+}
+
+void
+enet_peer_unindex_sent_reliable_command (ENetPeer * peer, ENetOutgoingCommand * outgoingCommand)
+{
+    ENetOutgoingCommand ** currentCommand;
+
+    if (peer -> sentReliableIndex == NULL)
+      return;
+
+    for (currentCommand = & peer -> sentReliableIndex [ENET_PEER_SENT_RELIABLE_BUCKET (peer, outgoingCommand -> reliableSequenceNumber, outgoingCommand -> command.header.channelID)];
+         * currentCommand != NULL;
+         currentCommand = & (* currentCommand) -> nextIndexedCommand)
+    {
+       if (* currentCommand == outgoingCommand)
+       {
+          * currentCommand = outgoingCommand -> nextIndexedCommand;
+
+          -- peer -> sentReliableIndexCount;
+
+          return;
+       }
+    }
+}
+
+static ENetIncomingCommand **
+enet_peer_incoming_reliable_slot (ENetChannel * channel, enet_uint16 reliableSequenceNumber, int create)
+{
+    ENetIncomingCommand ** block;
+
+    if (channel -> incomingReliableIndex == NULL)
+    {
+       if (! create)
+         return NULL;
+
+       channel -> incomingReliableIndex = (ENetIncomingCommand ***) enet_malloc (ENET_PEER_RELIABLE_INDEX_BLOCKS * sizeof (ENetIncomingCommand **));
+       if (channel -> incomingReliableIndex == NULL)
+         return NULL;
+
+       memset (channel -> incomingReliableIndex, 0, ENET_PEER_RELIABLE_INDEX_BLOCKS * sizeof (ENetIncomingCommand **));
+    }
+
+    block = channel -> incomingReliableIndex [reliableSequenceNumber / ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE];
+    if (block == NULL)
+    {
+       if (! create)
+         return NULL;
+
+       block = (ENetIncomingCommand **) enet_malloc (ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE * sizeof (ENetIncomingCommand *));
+       if (block == NULL)
+         return NULL;
+
+       memset (block, 0, ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE * sizeof (ENetIncomingCommand *));
+
+       channel -> incomingReliableIndex [reliableSequenceNumber / ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE] = block;
+    }
+
+    return & block [reliableSequenceNumber % ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE];
+}
+
+/** Looks up the queued incoming reliable command with the given sequence number.
+    @param channel channel to search
+    @param reliableSequenceNumber reliable sequence number of the command
+    @returns the command, or NULL if no command with this sequence number is waiting on the channel
+*/
+ENetIncomingCommand *
+enet_peer_find_incoming_reliable_command (ENetChannel * channel, enet_uint16 reliableSequenceNumber)
+{
+    ENetIncomingCommand ** slot = enet_peer_incoming_reliable_slot (channel, reliableSequenceNumber, 0);
+
+    return slot != NULL ? * slot : NULL;
+}
+
+/** Finds the queued incoming reliable command that a new command with the given sequence number
+    must follow, by walking the index backwards from the sequence number and skipping empty blocks.
+    Returns the list end if the new command belongs at the front of the queue.
+*/
+static ENetListIterator
+enet_peer_find_incoming_reliable_position (ENetChannel * channel, enet_uint16 reliableSequenceNumber)
+{
+    ENetListIterator currentCommand = enet_list_previous (enet_list_end (& channel -> incomingReliableCommands));
+    enet_uint16 offset = reliableSequenceNumber - channel -> incomingReliableSequenceNumber;
+
+    if (currentCommand == enet_list_end (& channel -> incomingReliableCommands) ||
+        (enet_uint16) (((ENetIncomingCommand *) currentCommand) -> reliableSequenceNumber - channel -> incomingReliableSequenceNumber) < offset)
+      return currentCommand;
+
+    for (-- offset; offset > 0; -- offset)
+    {
+       enet_uint16 sequenceNumber = channel -> incomingReliableSequenceNumber + offset;
+       ENetIncomingCommand ** block = channel -> incomingReliableIndex [sequenceNumber / ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE];
+
+       if (block == NULL)
+       {
+          if (sequenceNumber % ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE >= offset)
+            break;
+
+          offset -= sequenceNumber % ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE;
+          continue;
+       }
+
+       if (block [sequenceNumber % ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE] != NULL)
+         return & block [sequenceNumber % ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE] -> incomingCommandList;
+    }
+
+    return enet_list_end (& channel -> incomingReliableCommands);
+}
+
+void
+enet_peer_activate (ENetPeer * peer)
+{
+    if (! peer -> isActive)
+    {
+        if (peer -> isScheduled)
+        {
+            enet_list_remove (& peer -> activeList);
+
+            peer -> isScheduled = 0;
+        }
+
+        enet_list_insert (enet_list_end (& peer -> host -> activePeers), & peer -> activeList);
+
+        peer -> isActive = 1;
+    }
+}
+
+void
+enet_peer_deactivate (ENetPeer * peer)
+{
+    if (peer -> isActive || peer -> isScheduled)
+    {
+        enet_list_remove (& peer -> activeList);
+
+        peer -> isActive = 0;
+        peer -> isScheduled = 0;
     }
 }
 
@@ -372,6 +823,8 @@ void
 enet_peer_reset (ENetPeer * peer)
 {
     enet_peer_on_disconnect (peer);
+
+    enet_peer_deactivate (peer);
         
     peer -> outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
     peer -> connectID = 0;
@@ -404,6 +857,14 @@ enet_peer_reset (ENetPeer * peer)
     peer -> packetThrottleInterval = ENET_PEER_PACKET_THROTTLE_INTERVAL;
     peer -> pingInterval = ENET_PEER_PING_INTERVAL;
     peer -> timeoutLimit = ENET_PEER_TIMEOUT_LIMIT;
+    peer -> acknowledgementDelay = 0;
+    peer -> acknowledgementThreshold = 0;
+    peer -> fastRetransmitThreshold = 0;
+    peer -> congestionWindow = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
+    peer -> pacingRate = 0;
+    peer -> pacing = 0;
+    peer -> pacingTokens = 0;
+    peer -> pacingTime = 0;
     peer -> timeoutMinimum = ENET_PEER_TIMEOUT_MINIMUM;
     peer -> timeoutMaximum = ENET_PEER_TIMEOUT_MAXIMUM;
     peer -> lastRoundTripTime = ENET_PEER_DEFAULT_ROUND_TRIP_TIME;
@@ -420,10 +881,19 @@ enet_peer_reset (ENetPeer * peer)
     peer -> outgoingUnsequencedGroup = 0;
     peer -> eventData = 0;
     peer -> totalWaitingData = 0;
+    peer -> acknowledgeRanges = 0;
 
     memset (peer -> unsequencedWindow, 0, sizeof (peer -> unsequencedWindow));
     
     enet_peer_reset_queues (peer);
+
+    if (peer -> sentReliableIndex != NULL)
+    {
+        enet_free (peer -> sentReliableIndex);
+
+        peer -> sentReliableIndex = NULL;
+        peer -> sentReliableIndexSize = 0;
+    }
 }
 
 /** Sends a ping request to a peer.
@@ -460,6 +930,9 @@ void
 enet_peer_ping_interval (ENetPeer * peer, enet_uint32 pingInterval)
 {
     peer -> pingInterval = pingInterval ? pingInterval : ENET_PEER_PING_INTERVAL;
+
+    if (peer -> state != ENET_PEER_STATE_DISCONNECTED)
+      enet_peer_activate (peer);
 }
 
 /** Sets the timeout parameters for a peer.
@@ -487,6 +960,73 @@ enet_peer_timeout (ENetPeer * peer, enet_uint32 timeoutLimit, enet_uint32 timeou
     peer -> timeoutMaximum = timeoutMaximum ? timeoutMaximum : ENET_PEER_TIMEOUT_MAXIMUM;
 }
 
+/** Sets how long acknowledgements to a peer may be held back.
+
+    Normally every acknowledgement is sent on the next service of the host, often in a datagram
+    that carries nothing else. With a delay, acknowledgements are held until outgoing packets
+    to the peer are queued for them to share a datagram with, until the oldest of them has been
+    held for the delay, or until the threshold number of them is pending, whichever comes first.
+    Acknowledgements are never held while the peer is connecting or disconnecting.
+
+    Held acknowledgements echo the sent time of the datagram they acknowledge advanced by the time
+    they were held, so the delay is kept out of the peer's round trip time measurements. The peer
+    still waits for the delay before it sees an acknowledgement, so the delay should stay well
+    below the round trip time of the link.
+
+    @param peer the peer to adjust
+    @param delay the longest time, in milliseconds, to hold an acknowledgement; 0 sends them immediately
+    @param threshold number of pending acknowledgements that are sent without waiting for the delay; 0 for no limit
+*/
+void
+enet_peer_acknowledgement_delay (ENetPeer * peer, enet_uint32 delay, enet_uint32 threshold)
+{
+    peer -> acknowledgementDelay = delay;
+    peer -> acknowledgementThreshold = threshold;
+
+    if (peer -> state != ENET_PEER_STATE_DISCONNECTED)
+      enet_peer_activate (peer);
+}
+
+/** Enables or disables fast retransmission of reliable commands to a peer.
+
+    Normally a lost reliable command is only resent once its retransmission timeout expires,
+    and the timeout doubles with each resend. With fast retransmission, the oldest unacknowledged
+    command is resent as soon as the given number of commands sent after it have been
+    acknowledged, including commands acknowledged beyond a gap in an acknowledgement range,
+    and its timeout is left as it was.
+
+    @param peer the peer to adjust
+    @param threshold number of later acknowledgements that trigger a resend; 0 disables fast retransmission
+*/
+void
+enet_peer_fast_retransmit (ENetPeer * peer, enet_uint32 threshold)
+{
+    peer -> fastRetransmitThreshold = threshold;
+}
+
+/** Configures whether datagrams to a peer are paced.
+
+    Without pacing, each service of the host sends as much data to the peer as its window allows
+    in one burst, which can overflow shallow queues along the path.  With pacing, a token bucket
+    spreads the datagrams out at the rate chosen by the host's congestion controller, see
+    ENetPeer::pacingRate, or otherwise at a little above the rate at which the peer's window is
+    sent once per round trip time, capped by the peer's incoming bandwidth.  At most
+    ENET_PEER_PACING_BURST_TIME milliseconds worth of data is sent back to back, and the host
+    schedules itself to be serviced again once the bucket has refilled.  Datagrams that only
+    acknowledge received commands are neither paced nor charged to the bucket.
+
+    @param peer the peer to adjust
+    @param pacing 1 to pace datagrams to the peer, 0 to send them as soon as possible
+    @sa enet_host_send_release_time()
+*/
+void
+enet_peer_pacing (ENetPeer * peer, int pacing)
+{
+    peer -> pacing = pacing;
+    peer -> pacingTokens = (int) peer -> mtu;
+    peer -> pacingTime = peer -> host -> serviceTime;
+}
+
 /** Force an immediate disconnection from a peer.
     @param peer peer to disconnect
     @param data data describing the disconnection
@@ -601,16 +1141,21 @@ enet_peer_queue_acknowledgement (ENetPeer * peer, const ENetProtocol * command,
           return NULL;
     }
 
-    acknowledgement = (ENetAcknowledgement *) enet_malloc (sizeof (ENetAcknowledgement));
+    acknowledgement = (ENetAcknowledgement *) enet_pool_allocate (& peer -> host -> acknowledgementPool);
     if (acknowledgement == NULL)
       return NULL;
 
     peer -> outgoingDataTotal += sizeof (ENetProtocolAcknowledge);
 
     acknowledgement -> sentTime = sentTime;
+    acknowledgement -> queueTime = peer -> host -> serviceTime;
     acknowledgement -> command = * command;
     
     enet_list_insert (enet_list_end (& peer -> acknowledgements), acknowledgement);
+
+    ++ peer -> acknowledgementCount;
+
+    enet_peer_activate (peer);
     
     return acknowledgement;
 }
@@ -659,6 +1204,9 @@ enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoin
     outgoingCommand -> sentTime = 0;
     outgoingCommand -> roundTripTimeout = 0;
     outgoingCommand -> roundTripTimeoutLimit = 0;
+    outgoingCommand -> laterAcknowledgements = 0;
+    outgoingCommand -> nextIndexedCommand = NULL;
+    outgoingCommand -> isInTransit = 0;
     outgoingCommand -> command.header.reliableSequenceNumber = ENET_HOST_TO_NET_16 (outgoingCommand -> reliableSequenceNumber);
 
     switch (outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK)
@@ -679,21 +1227,25 @@ enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoin
       enet_list_insert (enet_list_end (& peer -> outgoingReliableCommands), outgoingCommand);
     else
       enet_list_insert (enet_list_end (& peer -> outgoingUnreliableCommands), outgoingCommand);
+
+    enet_peer_activate (peer);
 }
 
 ENetOutgoingCommand *
 enet_peer_queue_outgoing_command (ENetPeer * peer, const ENetProtocol * command, ENetPacket * packet, enet_uint32 offset, enet_uint16 length)
 {
-    ENetOutgoingCommand * outgoingCommand = (ENetOutgoingCommand *) enet_malloc (sizeof (ENetOutgoingCommand));
+    ENetOutgoingCommand * outgoingCommand = (ENetOutgoingCommand *) enet_pool_allocate (& peer -> host -> outgoingCommandPool);
     if (outgoingCommand == NULL)
       return NULL;
 
+    outgoingCommand -> block = NULL;
+    outgoingCommand -> streamFragments = 0;
     outgoingCommand -> command = * command;
     outgoingCommand -> fragmentOffset = offset;
     outgoingCommand -> fragmentLength = length;
     outgoingCommand -> packet = packet;
     if (packet != NULL)
-      ++ packet -> referenceCount;
+      enet_packet_add_references (packet, 1);
 
     enet_peer_setup_outgoing_command (peer, outgoingCommand);
 
@@ -780,13 +1332,16 @@ enet_peer_dispatch_incoming_unreliable_commands (ENetPeer * peer, ENetChannel *
        droppedCommand = currentCommand;
     }
 
-    enet_peer_remove_incoming_commands (& channel -> incomingUnreliableCommands, enet_list_begin (& channel -> incomingUnreliableCommands), droppedCommand);
+    enet_peer_remove_incoming_commands (peer, & channel -> incomingUnreliableCommands, enet_list_begin (& channel -> incomingUnreliableCommands), droppedCommand);
 }
 
 void
 enet_peer_dispatch_incoming_reliable_commands (ENetPeer * peer, ENetChannel * channel)
 {
     ENetListIterator currentCommand;
+    ENetIncomingCommand ** slot;
+    enet_uint16 oldSequenceNumber = channel -> incomingReliableSequenceNumber;
+    size_t block;
 
     for (currentCommand = enet_list_begin (& channel -> incomingReliableCommands);
          currentCommand != enet_list_end (& channel -> incomingReliableCommands);
@@ -798,6 +1353,10 @@ enet_peer_dispatch_incoming_reliable_commands (ENetPeer * peer, ENetChannel * ch
            incomingCommand -> reliableSequenceNumber != (enet_uint16) (channel -> incomingReliableSequenceNumber + 1))
          break;
 
+       slot = enet_peer_incoming_reliable_slot (channel, incomingCommand -> reliableSequenceNumber, 0);
+       if (slot != NULL)
+         * slot = NULL;
+
        channel -> incomingReliableSequenceNumber = incomingCommand -> reliableSequenceNumber;
 
        if (incomingCommand -> fragmentCount > 0)
@@ -807,6 +1366,18 @@ enet_peer_dispatch_incoming_reliable_commands (ENetPeer * peer, ENetChannel * ch
     if (currentCommand == enet_list_begin (& channel -> incomingReliableCommands))
       return;
 
+    for (block = oldSequenceNumber / ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE;
+         block != channel -> incomingReliableSequenceNumber / ENET_PEER_RELIABLE_INDEX_BLOCK_SIZE;
+         block = (block + 1) % ENET_PEER_RELIABLE_INDEX_BLOCKS)
+    {
+       if (channel -> incomingReliableIndex [block] != NULL)
+       {
+          enet_free (channel -> incomingReliableIndex [block]);
+
+          channel -> incomingReliableIndex [block] = NULL;
+       }
+    }
+
     channel -> incomingUnreliableSequenceNumber = 0;
 
     enet_list_move (enet_list_end (& peer -> dispatchedCommands), enet_list_begin (& channel -> incomingReliableCommands), enet_list_previous (currentCommand));
@@ -830,7 +1401,7 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     ENetChannel * channel = & peer -> channels [command -> header.channelID];
     enet_uint32 unreliableSequenceNumber = 0, reliableSequenceNumber = 0;
     enet_uint16 reliableWindow, currentWindow;
-    ENetIncomingCommand * incomingCommand;
+    ENetIncomingCommand * incomingCommand, ** reliableSlot = NULL;
     ENetListIterator currentCommand;
     ENetPacket * packet = NULL;
 
@@ -856,30 +1427,15 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
        if (reliableSequenceNumber == channel -> incomingReliableSequenceNumber)
          goto discardCommand;
-       
-       for (currentCommand = enet_list_previous (enet_list_end (& channel -> incomingReliableCommands));
-            currentCommand != enet_list_end (& channel -> incomingReliableCommands);
-            currentCommand = enet_list_previous (currentCommand))
-       {
-          incomingCommand = (ENetIncomingCommand *) currentCommand;
 
-          if (reliableSequenceNumber >= channel -> incomingReliableSequenceNumber)
-          {
-             if (incomingCommand -> reliableSequenceNumber < channel -> incomingReliableSequenceNumber)
-               continue;
-          }
-          else
-          if (incomingCommand -> reliableSequenceNumber >= channel -> incomingReliableSequenceNumber)
-            break;
+       reliableSlot = enet_peer_incoming_reliable_slot (channel, reliableSequenceNumber, 1);
+       if (reliableSlot == NULL)
+         goto notifyError;
 
-          if (incomingCommand -> reliableSequenceNumber <= reliableSequenceNumber)
-          {
-             if (incomingCommand -> reliableSequenceNumber < reliableSequenceNumber)
-               break;
+       if (* reliableSlot != NULL)
+         goto discardCommand;
 
-             goto discardCommand;
-          }
-       }
+       currentCommand = enet_peer_find_incoming_reliable_position (channel, reliableSequenceNumber);
        break;
 
     case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
@@ -935,11 +1491,17 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     if (peer -> totalWaitingData >= peer -> host -> maximumWaitingData)
       goto notifyError;
 
-    packet = enet_packet_create (data, dataLength, flags);
+    if (data != NULL &&
+        peer -> host -> receivedBuffer != NULL &&
+        (const enet_uint8 *) data >= peer -> host -> receivedBuffer -> data &&
+        (const enet_uint8 *) data + dataLength <= peer -> host -> receivedBuffer -> data + peer -> host -> receivedBuffer -> dataLength)
+      packet = enet_packet_create_from_receive_buffer (peer -> host -> receivedBuffer, data, dataLength, flags);
+    else
+      packet = enet_packet_create (data, dataLength, flags);
     if (packet == NULL)
       goto notifyError;
 
-    incomingCommand = (ENetIncomingCommand *) enet_malloc (sizeof (ENetIncomingCommand));
+    incomingCommand = (ENetIncomingCommand *) enet_pool_allocate (& peer -> host -> incomingCommandPool);
     if (incomingCommand == NULL)
       goto notifyError;
 
@@ -957,7 +1519,7 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
          incomingCommand -> fragments = (enet_uint32 *) enet_malloc ((fragmentCount + 31) / 32 * sizeof (enet_uint32));
        if (incomingCommand -> fragments == NULL)
        {
-          enet_free (incomingCommand);
+          enet_pool_free (& peer -> host -> incomingCommandPool, incomingCommand);
 
           goto notifyError;
        }
@@ -968,11 +1530,14 @@ enet_peer_queue_incoming_command (ENetPeer * peer, const ENetProtocol * command,
     {
        ++ packet -> referenceCount;
       
-       peer -> totalWaitingData += packet -> dataLength;
+       peer -> totalWaitingData += enet_peer_waiting_data_size (packet);
     }
 
     enet_list_insert (enet_list_next (currentCommand), incomingCommand);
 
+    if (reliableSlot != NULL)
+      * reliableSlot = incomingCommand;
+
     switch (command -> header.command & ENET_PROTOCOL_COMMAND_MASK)
     {
     case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
@@ -0,0 +1,198 @@
+/**
+ @file  pool.c
+ @brief ENet fixed-size object pools
+*/
+#define ENET_BUILDING_LIB 1
+#include "enet/enet.h"
+
+/**
+    @defgroup pool ENet fixed-size object pools
+    @ingroup private
+    @{
+*/
+
+typedef union _ENetPoolAlignment
+{
+   void * pointer;
+   double number;
+   long integer;
+} ENetPoolAlignment;
+
+typedef struct _ENetPoolSlab
+{
+   ENetListNode slabList;
+   void *       freeObjects;
+   size_t       usedObjects;
+} ENetPoolSlab;
+
+#define ENET_POOL_ALIGN(size) \
+    (((size) + sizeof (ENetPoolAlignment) - 1) / sizeof (ENetPoolAlignment) * sizeof (ENetPoolAlignment))
+
+#define ENET_POOL_CHUNK_SIZE(pool) \
+    (sizeof (ENetPoolAlignment) + (pool) -> objectSize)
+
+/** Initializes an empty pool.
+    @param pool pool to initialize
+    @param objectSize size of each object handed out by the pool
+    @param slabSize number of objects carved out of each slab allocated by the pool
+    @param freeLimit number of idle objects retained before empty slabs are released
+*/
+void
+enet_pool_initialize (ENetPool * pool, size_t objectSize, size_t slabSize, size_t freeLimit)
+{
+    if (objectSize < sizeof (void *))
+      objectSize = sizeof (void *);
+
+    pool -> objectSize = ENET_POOL_ALIGN (objectSize);
+    pool -> slabSize = slabSize > 0 ? slabSize : 1;
+    pool -> freeLimit = freeLimit;
+    pool -> slabCount = 0;
+    pool -> freeObjects = 0;
+    pool -> usedObjects = 0;
+    pool -> peakObjects = 0;
+    pool -> totalAllocations = 0;
+
+    enet_list_clear (& pool -> freeSlabs);
+}
+
+static void
+enet_pool_release_slab (ENetPool * pool, ENetPoolSlab * slab)
+{
+    enet_list_remove (& slab -> slabList);
+
+    pool -> freeObjects -= pool -> slabSize;
+    -- pool -> slabCount;
+
+    enet_free (slab);
+}
+
+/** Releases all slabs held by the pool.
+    @param pool pool to destroy
+    @remarks All objects must have been returned to the pool with enet_pool_free().
+*/
+void
+enet_pool_destroy (ENetPool * pool)
+{
+    while (! enet_list_empty (& pool -> freeSlabs))
+      enet_pool_release_slab (pool, (ENetPoolSlab *) enet_list_front (& pool -> freeSlabs));
+}
+
+/** Releases empty slabs until no more than the pool's free limit of idle objects remain.
+    @param pool pool to trim
+*/
+void
+enet_pool_trim (ENetPool * pool)
+{
+    ENetListIterator currentSlab = enet_list_begin (& pool -> freeSlabs);
+
+    while (currentSlab != enet_list_end (& pool -> freeSlabs) &&
+           pool -> freeObjects > pool -> freeLimit)
+    {
+       ENetPoolSlab * slab = (ENetPoolSlab *) currentSlab;
+
+       currentSlab = enet_list_next (currentSlab);
+
+       if (slab -> usedObjects == 0)
+         enet_pool_release_slab (pool, slab);
+    }
+}
+
+static ENetPoolSlab *
+enet_pool_create_slab (ENetPool * pool)
+{
+    ENetPoolSlab * slab = (ENetPoolSlab *) enet_malloc (ENET_POOL_ALIGN (sizeof (ENetPoolSlab)) + pool -> slabSize * ENET_POOL_CHUNK_SIZE (pool));
+    enet_uint8 * chunk;
+    size_t i;
+
+    if (slab == NULL)
+      return NULL;
+
+    slab -> freeObjects = NULL;
+    slab -> usedObjects = 0;
+
+    chunk = (enet_uint8 *) slab + ENET_POOL_ALIGN (sizeof (ENetPoolSlab)) + pool -> slabSize * ENET_POOL_CHUNK_SIZE (pool);
+
+    for (i = 0; i < pool -> slabSize; ++ i)
+    {
+       void * object;
+
+       chunk -= ENET_POOL_CHUNK_SIZE (pool);
+
+       ((ENetPoolAlignment *) chunk) -> pointer = slab;
+
+       object = chunk + sizeof (ENetPoolAlignment);
+       * (void **) object = slab -> freeObjects;
+       slab -> freeObjects = object;
+    }
+
+    enet_list_insert (enet_list_begin (& pool -> freeSlabs), slab);
+
+    pool -> freeObjects += pool -> slabSize;
+    ++ pool -> slabCount;
+
+    return slab;
+}
+
+/** Takes an object from the pool, allocating a new slab if no idle objects remain.
+    @param pool pool to allocate from
+    @returns the object, or NULL if a new slab could not be allocated
+*/
+void *
+enet_pool_allocate (ENetPool * pool)
+{
+    ENetPoolSlab * slab;
+    void * object;
+
+    if (enet_list_empty (& pool -> freeSlabs))
+    {
+       slab = enet_pool_create_slab (pool);
+       if (slab == NULL)
+         return NULL;
+    }
+    else
+      slab = (ENetPoolSlab *) enet_list_front (& pool -> freeSlabs);
+
+    object = slab -> freeObjects;
+    slab -> freeObjects = * (void **) object;
+
+    if (slab -> freeObjects == NULL)
+      enet_list_remove (& slab -> slabList);
+
+    ++ slab -> usedObjects;
+
+    -- pool -> freeObjects;
+    ++ pool -> usedObjects;
+    ++ pool -> totalAllocations;
+
+    if (pool -> usedObjects > pool -> peakObjects)
+      pool -> peakObjects = pool -> usedObjects;
+
+    return object;
+}
+
+/** Returns an object to the pool it was allocated from.
+    @param pool pool the object was allocated from
+    @param object object to return
+    @remarks The object's slab is released once it is empty and the pool holds more than its free limit of idle objects.
+*/
+void
+enet_pool_free (ENetPool * pool, void * object)
+{
+    ENetPoolSlab * slab = (ENetPoolSlab *) ((ENetPoolAlignment *) object) [-1].pointer;
+
+    if (slab -> freeObjects == NULL)
+      enet_list_insert (enet_list_begin (& pool -> freeSlabs), slab);
+
+    * (void **) object = slab -> freeObjects;
+    slab -> freeObjects = object;
+
+    -- slab -> usedObjects;
+
+    ++ pool -> freeObjects;
+    -- pool -> usedObjects;
+
+    if (slab -> usedObjects == 0 && pool -> freeObjects > pool -> freeLimit)
+      enet_pool_release_slab (pool, slab);
+}
+
+/** @} */
@@ -9,6 +9,8 @@
 #include "enet/time.h"
 #include "enet/enet.h"
 
+#define ENET_PEER_FROM_ACTIVE_LIST(iterator) ((ENetPeer *) ((enet_uint8 *) (iterator) - (size_t) & ((ENetPeer *) 0) -> activeList))
+
 static size_t commandSizes [ENET_PROTOCOL_COMMAND_COUNT] =
 {
     0,
@@ -23,7 +25,8 @@ static size_t commandSizes [ENET_PROTOCOL_COMMAND_COUNT] =
     sizeof (ENetProtocolSendUnsequenced),
     sizeof (ENetProtocolBandwidthLimit),
     sizeof (ENetProtocolThrottleConfigure),
-    sizeof (ENetProtocolSendFragment)
+    sizeof (ENetProtocolSendFragment),
+    sizeof (ENetProtocolAcknowledgeRange)
 };
 
 size_t
@@ -171,9 +174,7 @@ enet_protocol_remove_sent_unreliable_commands (ENetPeer * peer)
 
         if (outgoingCommand -> packet != NULL)
         {
-           -- outgoingCommand -> packet -> referenceCount;
-
-           if (outgoingCommand -> packet -> referenceCount == 0)
+           if (enet_packet_remove_reference (outgoingCommand -> packet) == 0)
            {
               outgoingCommand -> packet -> flags |= ENET_PACKET_FLAG_SENT;
  
@@ -181,52 +182,95 @@ enet_protocol_remove_sent_unreliable_commands (ENetPeer * peer)
            }
         }
 
-        enet_free (outgoingCommand);
+        enet_peer_free_outgoing_command (peer, outgoingCommand);
+    }
+}
+
+/** Counts an acknowledgement of a command against the oldest command still awaiting acknowledgement,
+    and moves that command back to the front of the outgoing queue once enough commands sent after it
+    have been acknowledged.  The sent reliable commands are kept in the order they were sent, so any
+    other acknowledged command was sent after it, even within the same millisecond.  Unlike a timeout,
+    this does not double the command's retransmission timeout.
+*/
+static void
+enet_protocol_fast_retransmit (ENetPeer * peer, ENetOutgoingCommand * acknowledgedCommand)
+{
+    ENetOutgoingCommand * outgoingCommand = (ENetOutgoingCommand *) enet_list_front (& peer -> sentReliableCommands);
+
+    if (outgoingCommand == acknowledgedCommand ||
+        ++ outgoingCommand -> laterAcknowledgements < peer -> fastRetransmitThreshold)
+      return;
+
+    if (outgoingCommand -> packet != NULL)
+    {
+       peer -> reliableDataInTransit -= outgoingCommand -> fragmentLength;
+
+       if (peer -> host -> congestionControl.onLoss != NULL)
+         (* peer -> host -> congestionControl.onLoss) (peer -> host -> congestionControl.context, peer, outgoingCommand -> fragmentLength);
     }
+
+    outgoingCommand -> isInTransit = 0;
+    outgoingCommand -> laterAcknowledgements = 0;
+
+    ++ peer -> packetsLost;
+    ++ peer -> totalPacketsLost;
+
+    enet_list_insert (enet_list_begin (& peer -> outgoingReliableCommands), enet_list_remove (& outgoingCommand -> outgoingCommandList));
 }
 
 static ENetProtocolCommand
-enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliableSequenceNumber, enet_uint8 channelID)
+enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliableSequenceNumber, enet_uint8 channelID, enet_uint32 * acknowledgedBytes)
 {
     ENetOutgoingCommand * outgoingCommand = NULL;
     ENetListIterator currentCommand;
     ENetProtocolCommand commandNumber;
-    int wasSent = 1;
+    int wasSent;
 
-    for (currentCommand = enet_list_begin (& peer -> sentReliableCommands);
-         currentCommand != enet_list_end (& peer -> sentReliableCommands);
-         currentCommand = enet_list_next (currentCommand))
+    outgoingCommand = enet_peer_find_sent_reliable_command (peer, reliableSequenceNumber, channelID);
+    if (outgoingCommand != NULL)
+      enet_peer_unindex_sent_reliable_command (peer, outgoingCommand);
+    else
     {
-       outgoingCommand = (ENetOutgoingCommand *) currentCommand;
-        
-       if (outgoingCommand -> reliableSequenceNumber == reliableSequenceNumber &&
-           outgoingCommand -> command.header.channelID == channelID)
-         break;
-    }
+       if (peer -> sentReliableUnindexed == 0)
+         return ENET_PROTOCOL_COMMAND_NONE;
 
-    if (currentCommand == enet_list_end (& peer -> sentReliableCommands))
-    {
-       for (currentCommand = enet_list_begin (& peer -> outgoingReliableCommands);
-            currentCommand != enet_list_end (& peer -> outgoingReliableCommands);
+       for (currentCommand = enet_list_begin (& peer -> sentReliableCommands);
+            currentCommand != enet_list_end (& peer -> sentReliableCommands);
             currentCommand = enet_list_next (currentCommand))
        {
           outgoingCommand = (ENetOutgoingCommand *) currentCommand;
-
-          if (outgoingCommand -> sendAttempts < 1) return ENET_PROTOCOL_COMMAND_NONE;
-
+        
           if (outgoingCommand -> reliableSequenceNumber == reliableSequenceNumber &&
               outgoingCommand -> command.header.channelID == channelID)
             break;
        }
 
-       if (currentCommand == enet_list_end (& peer -> outgoingReliableCommands))
-         return ENET_PROTOCOL_COMMAND_NONE;
+       if (currentCommand == enet_list_end (& peer -> sentReliableCommands))
+       {
+          for (currentCommand = enet_list_begin (& peer -> outgoingReliableCommands);
+               currentCommand != enet_list_end (& peer -> outgoingReliableCommands);
+               currentCommand = enet_list_next (currentCommand))
+          {
+             outgoingCommand = (ENetOutgoingCommand *) currentCommand;
+
+             if (outgoingCommand -> sendAttempts < 1) return ENET_PROTOCOL_COMMAND_NONE;
+
+             if (outgoingCommand -> reliableSequenceNumber == reliableSequenceNumber &&
+                 outgoingCommand -> command.header.channelID == channelID)
+               break;
+          }
+
+          if (currentCommand == enet_list_end (& peer -> outgoingReliableCommands))
+            return ENET_PROTOCOL_COMMAND_NONE;
+       }
 
-       wasSent = 0;
+       -- peer -> sentReliableUnindexed;
     }
 
-    if (outgoingCommand == NULL)
-      return ENET_PROTOCOL_COMMAND_NONE;
+    wasSent = outgoingCommand -> isInTransit;
+
+    if (wasSent && peer -> fastRetransmitThreshold > 0)
+      enet_protocol_fast_retransmit (peer, outgoingCommand);
 
     if (channelID < peer -> channelCount)
     {
@@ -249,9 +293,10 @@ enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliabl
        if (wasSent)
          peer -> reliableDataInTransit -= outgoingCommand -> fragmentLength;
 
-       -- outgoingCommand -> packet -> referenceCount;
+       if (acknowledgedBytes != NULL)
+         * acknowledgedBytes += outgoingCommand -> fragmentLength;
 
-       if (outgoingCommand -> packet -> referenceCount == 0)
+       if (enet_packet_remove_reference (outgoingCommand -> packet) == 0)
        {
           outgoingCommand -> packet -> flags |= ENET_PACKET_FLAG_SENT;
 
@@ -259,7 +304,7 @@ enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliabl
        }
     }
 
-    enet_free (outgoingCommand);
+    enet_peer_free_outgoing_command (peer, outgoingCommand);
 
     if (enet_list_empty (& peer -> sentReliableCommands))
       return commandNumber;
@@ -327,6 +372,7 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
     peer -> packetThrottleAcceleration = ENET_NET_TO_HOST_32 (command -> connect.packetThrottleAcceleration);
     peer -> packetThrottleDeceleration = ENET_NET_TO_HOST_32 (command -> connect.packetThrottleDeceleration);
     peer -> eventData = ENET_NET_TO_HOST_32 (command -> connect.data);
+    peer -> acknowledgeRanges = host -> acknowledgeRanges && (command -> header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE_RANGES);
 
     incomingSessionID = command -> connect.incomingSessionID == 0xFF ? peer -> outgoingSessionID : command -> connect.incomingSessionID;
     incomingSessionID = (incomingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
@@ -347,6 +393,7 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
         channel -> outgoingReliableSequenceNumber = 0;
         channel -> outgoingUnreliableSequenceNumber = 0;
         channel -> incomingReliableSequenceNumber = 0;
+        channel -> incomingReliableIndex = NULL;
         channel -> incomingUnreliableSequenceNumber = 0;
 
         enet_list_clear (& channel -> incomingReliableCommands);
@@ -402,6 +449,8 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
       windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
 
     verifyCommand.header.command = ENET_PROTOCOL_COMMAND_VERIFY_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+    if (peer -> acknowledgeRanges)
+      verifyCommand.header.command |= ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE_RANGES;
     verifyCommand.header.channelID = 0xFF;
     verifyCommand.verifyConnect.outgoingPeerID = ENET_HOST_TO_NET_16 (peer -> incomingPeerID);
     verifyCommand.verifyConnect.incomingSessionID = incomingSessionID;
@@ -522,7 +571,6 @@ enet_protocol_handle_send_fragment (ENetHost * host, ENetPeer * peer, const ENet
            totalLength;
     ENetChannel * channel;
     enet_uint16 startWindow, currentWindow;
-    ENetListIterator currentCommand;
     ENetIncomingCommand * startCommand = NULL;
 
     if (command -> header.channelID >= peer -> channelCount ||
@@ -559,35 +607,12 @@ enet_protocol_handle_send_fragment (ENetHost * host, ENetPeer * peer, const ENet
         fragmentLength > totalLength - fragmentOffset)
       return -1;
  
-    for (currentCommand = enet_list_previous (enet_list_end (& channel -> incomingReliableCommands));
-         currentCommand != enet_list_end (& channel -> incomingReliableCommands);
-         currentCommand = enet_list_previous (currentCommand))
-    {
-       ENetIncomingCommand * incomingCommand = (ENetIncomingCommand *) currentCommand;
-
-       if (startSequenceNumber >= channel -> incomingReliableSequenceNumber)
-       {
-          if (incomingCommand -> reliableSequenceNumber < channel -> incomingReliableSequenceNumber)
-            continue;
-       }
-       else
-       if (incomingCommand -> reliableSequenceNumber >= channel -> incomingReliableSequenceNumber)
-         break;
-
-       if (incomingCommand -> reliableSequenceNumber <= startSequenceNumber)
-       {
-          if (incomingCommand -> reliableSequenceNumber < startSequenceNumber)
-            break;
-        
-          if ((incomingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_FRAGMENT ||
-              totalLength != incomingCommand -> packet -> dataLength ||
-              fragmentCount != incomingCommand -> fragmentCount)
-            return -1;
-
-          startCommand = incomingCommand;
-          break;
-       }
-    }
+    startCommand = enet_peer_find_incoming_reliable_command (channel, startSequenceNumber);
+    if (startCommand != NULL &&
+        ((startCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK) != ENET_PROTOCOL_COMMAND_SEND_FRAGMENT ||
+         totalLength != startCommand -> packet -> dataLength ||
+         fragmentCount != startCommand -> fragmentCount))
+      return -1;
  
     if (startCommand == NULL)
     {
@@ -819,24 +844,22 @@ enet_protocol_handle_disconnect (ENetHost * host, ENetPeer * peer, const ENetPro
     return 0;
 }
 
-static int
-enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer * peer, const ENetProtocol * command)
+static void
+enet_protocol_update_round_trip_time (ENetHost * host, ENetPeer * peer, enet_uint16 sentTime, enet_uint32 * sample)
 {
     enet_uint32 roundTripTime,
-           receivedSentTime,
-           receivedReliableSequenceNumber;
-    ENetProtocolCommand commandNumber;
-
-    if (peer -> state == ENET_PEER_STATE_DISCONNECTED || peer -> state == ENET_PEER_STATE_ZOMBIE)
-      return 0;
+           receivedSentTime;
 
-    receivedSentTime = ENET_NET_TO_HOST_16 (command -> acknowledge.receivedSentTime);
+    receivedSentTime = ENET_NET_TO_HOST_16 (sentTime);
     receivedSentTime |= host -> serviceTime & 0xFFFF0000;
     if ((receivedSentTime & 0x8000) > (host -> serviceTime & 0x8000))
         receivedSentTime -= 0x10000;
 
+    /* A peer that held the acknowledgement advances the echoed time by the hold, which rounding
+       to milliseconds may carry a little past the current time.  Count that as no delay at all
+       rather than dropping the acknowledgement. */
     if (ENET_TIME_LESS (host -> serviceTime, receivedSentTime))
-      return 0;
+      receivedSentTime = host -> serviceTime;
 
     peer -> lastReceiveTime = host -> serviceTime;
     peer -> earliestTimeout = 0;
@@ -845,6 +868,8 @@ enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer *
 
     enet_peer_throttle (peer, roundTripTime);
 
+    * sample = roundTripTime;
+
     peer -> roundTripTimeVariance -= peer -> roundTripTimeVariance / 4;
 
     if (roundTripTime >= peer -> roundTripTime)
@@ -873,10 +898,14 @@ enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer *
         peer -> highestRoundTripTimeVariance = peer -> roundTripTimeVariance;
         peer -> packetThrottleEpoch = host -> serviceTime;
     }
+}
 
-    receivedReliableSequenceNumber = ENET_NET_TO_HOST_16 (command -> acknowledge.receivedReliableSequenceNumber);
-
-    commandNumber = enet_protocol_remove_sent_reliable_command (peer, receivedReliableSequenceNumber, command -> header.channelID);
+static int
+enet_protocol_handle_acknowledged_command (ENetHost * host, ENetEvent * event, ENetPeer * peer, ENetProtocolCommand commandNumber)
+{
+    if (! enet_list_empty (& peer -> outgoingReliableCommands) ||
+        enet_list_empty (& peer -> sentReliableCommands))
+      enet_peer_activate (peer);
 
     switch (peer -> state)
     {
@@ -908,6 +937,66 @@ enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer *
     return 0;
 }
 
+static int
+enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer * peer, const ENetProtocol * command)
+{
+    enet_uint32 receivedReliableSequenceNumber,
+           roundTripTime,
+           acknowledgedBytes = 0;
+    ENetProtocolCommand commandNumber;
+
+    if (peer -> state == ENET_PEER_STATE_DISCONNECTED || peer -> state == ENET_PEER_STATE_ZOMBIE)
+      return 0;
+
+    enet_protocol_update_round_trip_time (host, peer, command -> acknowledge.receivedSentTime, & roundTripTime);
+
+    receivedReliableSequenceNumber = ENET_NET_TO_HOST_16 (command -> acknowledge.receivedReliableSequenceNumber);
+
+    commandNumber = enet_protocol_remove_sent_reliable_command (peer, receivedReliableSequenceNumber, command -> header.channelID, & acknowledgedBytes);
+
+    if (host -> congestionControl.onAcknowledge != NULL)
+      (* host -> congestionControl.onAcknowledge) (host -> congestionControl.context, peer, acknowledgedBytes, roundTripTime);
+
+    return enet_protocol_handle_acknowledged_command (host, event, peer, commandNumber);
+}
+
+static int
+enet_protocol_handle_acknowledge_range (ENetHost * host, ENetEvent * event, ENetPeer * peer, const ENetProtocol * command)
+{
+    enet_uint16 receivedReliableSequenceNumber;
+    enet_uint32 receivedMask,
+           roundTripTime,
+           acknowledgedBytes = 0;
+    ENetProtocolCommand commandNumber, rangeCommandNumber;
+
+    if (peer -> state == ENET_PEER_STATE_DISCONNECTED || peer -> state == ENET_PEER_STATE_ZOMBIE)
+      return 0;
+
+    enet_protocol_update_round_trip_time (host, peer, command -> acknowledgeRange.receivedSentTime, & roundTripTime);
+
+    receivedReliableSequenceNumber = ENET_NET_TO_HOST_16 (command -> acknowledgeRange.receivedReliableSequenceNumber);
+    receivedMask = ENET_NET_TO_HOST_32 (command -> acknowledgeRange.receivedMask);
+
+    rangeCommandNumber = enet_protocol_remove_sent_reliable_command (peer, receivedReliableSequenceNumber, command -> header.channelID, & acknowledgedBytes);
+
+    for (; receivedMask != 0; receivedMask >>= 1)
+    {
+       ++ receivedReliableSequenceNumber;
+
+       if (! (receivedMask & 1))
+         continue;
+
+       commandNumber = enet_protocol_remove_sent_reliable_command (peer, receivedReliableSequenceNumber, command -> header.channelID, & acknowledgedBytes);
+       if (commandNumber != ENET_PROTOCOL_COMMAND_NONE)
+         rangeCommandNumber = commandNumber;
+    }
+
+    if (host -> congestionControl.onAcknowledge != NULL)
+      (* host -> congestionControl.onAcknowledge) (host -> congestionControl.context, peer, acknowledgedBytes, roundTripTime);
+
+    return enet_protocol_handle_acknowledged_command (host, event, peer, rangeCommandNumber);
+}
+
 static int
 enet_protocol_handle_verify_connect (ENetHost * host, ENetEvent * event, ENetPeer * peer, const ENetProtocol * command)
 {
@@ -932,7 +1021,7 @@ enet_protocol_handle_verify_connect (ENetHost * host, ENetEvent * event, ENetPee
         return -1;
     }
 
-    enet_protocol_remove_sent_reliable_command (peer, 1, 0xFF);
+    enet_protocol_remove_sent_reliable_command (peer, 1, 0xFF, NULL);
     
     if (channelCount < peer -> channelCount)
       peer -> channelCount = channelCount;
@@ -940,6 +1029,7 @@ enet_protocol_handle_verify_connect (ENetHost * host, ENetEvent * event, ENetPee
     peer -> outgoingPeerID = ENET_NET_TO_HOST_16 (command -> verifyConnect.outgoingPeerID);
     peer -> incomingSessionID = command -> verifyConnect.incomingSessionID;
     peer -> outgoingSessionID = command -> verifyConnect.outgoingSessionID;
+    peer -> acknowledgeRanges = host -> acknowledgeRanges && (command -> header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE_RANGES);
 
     mtu = ENET_NET_TO_HOST_32 (command -> verifyConnect.mtu);
 
@@ -1089,6 +1179,11 @@ enet_protocol_handle_incoming_commands (ENetHost * host, ENetEvent * event)
             goto commandError;
           break;
 
+       case ENET_PROTOCOL_COMMAND_ACKNOWLEDGE_RANGE:
+          if (enet_protocol_handle_acknowledge_range (host, event, peer, command))
+            goto commandError;
+          break;
+
        case ENET_PROTOCOL_COMMAND_CONNECT:
           if (peer != NULL)
             goto commandError;
@@ -1188,6 +1283,36 @@ commandError:
     return 0;
 }
  
+static int
+enet_protocol_refresh_receive_buffers (ENetHost * host)
+{
+    size_t i;
+
+    for (i = 0; i < host -> receiveBatchSize; ++ i)
+    {
+       ENetReceiveBuffer * buffer = host -> receiveBatchBuffers [i];
+
+       if (buffer != NULL)
+       {
+          if (buffer -> referenceCount <= 1)
+            continue;
+
+          enet_host_release_receive_buffer (buffer);
+       }
+
+       buffer = enet_host_acquire_receive_buffer (host, host -> receiveBatch [i].buffers [0].dataLength);
+
+       host -> receiveBatchBuffers [i] = buffer;
+
+       if (buffer == NULL)
+         return -1;
+
+       host -> receiveBatch [i].buffers [0].data = buffer -> data;
+    }
+
+    return 0;
+}
+
 static int
 enet_protocol_receive_incoming_commands (ENetHost * host, ENetEvent * event)
 {
@@ -1196,21 +1321,108 @@ enet_protocol_receive_incoming_commands (ENetHost * host, ENetEvent * event)
        int receivedLength;
        ENetBuffer buffer;
 
-       buffer.data = host -> packetData [0];
-       buffer.dataLength = sizeof (host -> packetData [0]);
+       host -> receivedBuffer = NULL;
+
+       if (host -> receiveBatch != NULL)
+       {
+          ENetDatagram * datagram;
 
-       receivedLength = enet_socket_receive (host -> socket,
-                                             & host -> receivedAddress,
-                                             & buffer,
-                                             1);
+          if (host -> receiveBatchPosition >= host -> receiveBatchCount)
+          {
+             int receivedCount;
 
-       if (receivedLength < 0)
-         return -1;
+             if (host -> receiveZeroCopy &&
+                 enet_protocol_refresh_receive_buffers (host) < 0)
+               return -1;
 
-       if (receivedLength == 0)
-         return 0;
+             receivedCount = enet_socket_receive_multiple (host -> socket,
+                                                               host -> receiveBatch,
+                                                               host -> receiveBatchSize);
+
+             host -> receiveBatchCount = 0;
+             host -> receiveBatchPosition = 0;
+             host -> receiveBatchOffset = 0;
+
+             if (receivedCount < 0)
+               return -1;
+
+             if (receivedCount == 0)
+               return 0;
+
+             host -> receiveBatchCount = receivedCount;
+          }
+
+          datagram = & host -> receiveBatch [host -> receiveBatchPosition];
+
+          if (datagram -> dataLength == 0)
+          {
+             ++ host -> receiveBatchPosition;
+
+             continue;
+          }
+
+          if (host -> receiveZeroCopy)
+            host -> receivedBuffer = host -> receiveBatchBuffers [host -> receiveBatchPosition];
+
+          host -> receivedAddress = datagram -> address;
+          host -> receivedData = (enet_uint8 *) datagram -> buffers [0].data + host -> receiveBatchOffset;
+
+          if (datagram -> segmentSize > 0 &&
+              host -> receiveBatchOffset + datagram -> segmentSize < datagram -> dataLength)
+          {
+             receivedLength = (int) datagram -> segmentSize;
+
+             host -> receiveBatchOffset += datagram -> segmentSize;
+          }
+          else
+          {
+             receivedLength = (int) (datagram -> dataLength - host -> receiveBatchOffset);
+
+             host -> receiveBatchOffset = 0;
+             ++ host -> receiveBatchPosition;
+          }
+       }
+       else
+       {
+          if (host -> receiveZeroCopy)
+          {
+             if (host -> receiveBuffer != NULL && host -> receiveBuffer -> referenceCount > 1)
+             {
+                enet_host_release_receive_buffer (host -> receiveBuffer);
+
+                host -> receiveBuffer = NULL;
+             }
+
+             if (host -> receiveBuffer == NULL)
+             {
+                host -> receiveBuffer = enet_host_acquire_receive_buffer (host, sizeof (host -> packetData [0]));
+                if (host -> receiveBuffer == NULL)
+                  return -1;
+             }
+
+             buffer.data = host -> receiveBuffer -> data;
+          }
+          else
+            buffer.data = host -> packetData [0];
+          buffer.dataLength = sizeof (host -> packetData [0]);
+
+          receivedLength = enet_socket_receive (host -> socket,
+                                                & host -> receivedAddress,
+                                                & buffer,
+                                                1);
+
+          if (receivedLength < 0)
+            return -1;
+
+          if (receivedLength == 0)
+            return 0;
+
+          if (host -> receiveZeroCopy)
+            host -> receivedBuffer = host -> receiveBuffer;
+
+          host -> receivedData = (enet_uint8 *) buffer.data;
+       }
 
-       host -> receivedData = host -> packetData [0];
        host -> receivedDataLength = receivedLength;
       
        host -> totalReceivedData += receivedLength;
@@ -1250,90 +1462,490 @@ enet_protocol_receive_incoming_commands (ENetHost * host, ENetEvent * event)
     return -1;
 }
 
-static void
-enet_protocol_send_acknowledgements (ENetHost * host, ENetPeer * peer)
+static int
+enet_protocol_send_segments (ENetHost * host, ENetDatagram * datagram)
 {
-    ENetProtocol * command = & host -> commands [host -> commandCount];
-    ENetBuffer * buffer = & host -> buffers [host -> bufferCount];
-    ENetAcknowledgement * acknowledgement;
-    ENetListIterator currentAcknowledgement;
-    enet_uint16 reliableSequenceNumber;
- 
-    currentAcknowledgement = enet_list_begin (& peer -> acknowledgements);
-         
-    while (currentAcknowledgement != enet_list_end (& peer -> acknowledgements))
-    {
-       if (command >= & host -> commands [sizeof (host -> commands) / sizeof (ENetProtocol)] ||
-           buffer >= & host -> buffers [sizeof (host -> buffers) / sizeof (ENetBuffer)] ||
-           peer -> mtu - host -> packetSize < sizeof (ENetProtocolAcknowledge))
-       {
-          host -> continueSending = 1;
-
-          break;
-       }
-
-       acknowledgement = (ENetAcknowledgement *) currentAcknowledgement;
- 
-       currentAcknowledgement = enet_list_next (currentAcknowledgement);
-
-       buffer -> data = command;
-       buffer -> dataLength = sizeof (ENetProtocolAcknowledge);
+    ENetOutgoingDatagram * outgoingDatagram;
+    size_t sentData = 0;
 
-       host -> packetSize += buffer -> dataLength;
+    for (outgoingDatagram = host -> sendBatchData;
+         outgoingDatagram < & host -> sendBatchData [host -> sendBatchDataCount];
+         ++ outgoingDatagram)
+    {
+       int sentLength;
 
-       reliableSequenceNumber = ENET_HOST_TO_NET_16 (acknowledgement -> command.header.reliableSequenceNumber);
-  
-       command -> header.command = ENET_PROTOCOL_COMMAND_ACKNOWLEDGE;
-       command -> header.channelID = acknowledgement -> command.header.channelID;
-       command -> header.reliableSequenceNumber = reliableSequenceNumber;
-       command -> acknowledge.receivedReliableSequenceNumber = reliableSequenceNumber;
-       command -> acknowledge.receivedSentTime = ENET_HOST_TO_NET_16 (acknowledgement -> sentTime);
-  
-       if ((acknowledgement -> command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_DISCONNECT)
-         enet_protocol_dispatch_state (host, peer, ENET_PEER_STATE_ZOMBIE);
+       if (outgoingDatagram -> buffers < datagram -> buffers ||
+           outgoingDatagram -> buffers >= & datagram -> buffers [datagram -> bufferCount])
+         continue;
 
-       enet_list_remove (& acknowledgement -> acknowledgementList);
-       enet_free (acknowledgement);
+       sentLength = enet_socket_send (host -> socket, & datagram -> address, outgoingDatagram -> buffers, outgoingDatagram -> bufferCount);
+       if (sentLength < 0)
+         return -1;
 
-       ++ command;
-       ++ buffer;
+       sentData += sentLength;
     }
 
-    host -> commandCount = command - host -> commands;
-    host -> bufferCount = buffer - host -> buffers;
+    datagram -> dataLength = sentData;
+    datagram -> segmentSize = 0;
+
+    return 0;
 }
 
+/** Compresses and checksums a datagram staged for a send worker, as the send pass does for
+    datagrams it finishes itself.  A datagram the send pass already compressed is only checksummed.
+*/
 static void
-enet_protocol_send_unreliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
+enet_protocol_finish_datagram (ENetHost * host, ENetOutgoingDatagram * outgoingDatagram, void * compressorContext)
 {
-    ENetProtocol * command = & host -> commands [host -> commandCount];
-    ENetBuffer * buffer = & host -> buffers [host -> bufferCount];
-    ENetOutgoingCommand * outgoingCommand;
-    ENetListIterator currentCommand;
+    ENetProtocolHeader * header = (ENetProtocolHeader *) outgoingDatagram -> headerData;
+    ENetBuffer * buffers = outgoingDatagram -> buffers;
+    ENetDatagram * datagram = outgoingDatagram -> datagram;
+    size_t shouldCompress = outgoingDatagram -> compressedSize;
 
-    currentCommand = enet_list_begin (& peer -> outgoingUnreliableCommands);
-    
-    while (currentCommand != enet_list_end (& peer -> outgoingUnreliableCommands))
+    if (host -> sendWorkerCompression && host -> compressor.context != NULL && host -> compressor.compress != NULL)
     {
-       size_t commandSize;
+        size_t originalSize = datagram -> dataLength - buffers -> dataLength,
+               compressedSize = host -> compressor.compress (compressorContext,
+                                    & buffers [1], outgoingDatagram -> bufferCount - 1,
+                                    originalSize,
+                                    outgoingDatagram -> packetData,
+                                    originalSize);
+        if (compressedSize > 0 && compressedSize < originalSize)
+        {
+            header -> peerID |= ENET_HOST_TO_NET_16 (ENET_PROTOCOL_HEADER_FLAG_COMPRESSED);
+            shouldCompress = compressedSize;
+        }
+    }
 
-       outgoingCommand = (ENetOutgoingCommand *) currentCommand;
-       commandSize = commandSizes [outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK];
+    if (host -> checksum != NULL)
+    {
+        enet_uint32 * checksum = (enet_uint32 *) & outgoingDatagram -> headerData [buffers -> dataLength - sizeof (enet_uint32)];
+        * checksum = host -> checksum (buffers, outgoingDatagram -> bufferCount);
+    }
 
-       if (command >= & host -> commands [sizeof (host -> commands) / sizeof (ENetProtocol)] ||
-           buffer + 1 >= & host -> buffers [sizeof (host -> buffers) / sizeof (ENetBuffer)] ||
-           peer -> mtu - host -> packetSize < commandSize ||
-           (outgoingCommand -> packet != NULL &&
-             peer -> mtu - host -> packetSize < commandSize + outgoingCommand -> fragmentLength))
-       {
-          host -> continueSending = 1;
+    if (shouldCompress > 0)
+    {
+        buffers [1].data = outgoingDatagram -> packetData;
+        buffers [1].dataLength = shouldCompress;
+        outgoingDatagram -> bufferCount = 2;
 
-          break;
-       }
+        datagram -> bufferCount = 2;
+        datagram -> dataLength = buffers -> dataLength + shouldCompress;
+    }
 
-       currentCommand = enet_list_next (currentCommand);
+    outgoingDatagram -> datagram = NULL;
+}
 
-       if (outgoingCommand -> packet != NULL && outgoingCommand -> fragmentOffset == 0)
+/** Finishes the datagrams staged for send workers until none are left to claim.
+    @param host host whose send batch is being finished
+    @param compressorContext context for the host's compressor owned by the calling thread
+*/
+void
+enet_protocol_finish_datagrams (ENetHost * host, void * compressorContext)
+{
+    for (;;)
+    {
+       size_t job = ENET_ATOMIC_INCREMENT (& host -> sendJobNext) - 1;
+
+       if (job >= host -> sendBatchDataCount)
+         break;
+
+       if (host -> sendBatchData [job].datagram != NULL)
+         enet_protocol_finish_datagram (host, & host -> sendBatchData [job], compressorContext);
+    }
+}
+
+static void
+enet_protocol_run_send_workers (ENetHost * host)
+{
+    size_t workerCount = host -> sendWorkerCount, i;
+
+    if (workerCount > host -> sendJobCount - 1)
+      workerCount = host -> sendJobCount - 1;
+
+    host -> sendJobNext = 0;
+
+    for (i = 0; i < workerCount; ++ i)
+      enet_semaphore_post (& host -> sendWorkerStart);
+
+    enet_protocol_finish_datagrams (host, host -> compressor.context);
+
+    for (i = 0; i < workerCount; ++ i)
+      enet_semaphore_wait (& host -> sendWorkerDone);
+
+    host -> sendJobCount = 0;
+}
+
+static int
+enet_protocol_send_datagrams (ENetHost * host)
+{
+    ENetDatagram * datagram = host -> sendBatch,
+                 * datagramEnd = & host -> sendBatch [host -> sendBatchCount];
+    size_t i;
+    int result = 0;
+
+    if (host -> sendBatchCount == 0)
+      return 0;
+
+    if (host -> sendJobCount > 0)
+      enet_protocol_run_send_workers (host);
+
+    while (datagram < datagramEnd)
+    {
+       int sentCount = enet_socket_send_multiple (host -> socket, datagram, datagramEnd - datagram);
+
+       if (sentCount <= 0)
+       {
+          if (datagram -> segmentSize == 0)
+          {
+             result = -1;
+
+             break;
+          }
+
+          /* The kernel rejected segmentation offload, so fall back to sending the datagrams individually. */
+          host -> sendSegmentation = 0;
+
+          if (enet_protocol_send_segments (host, datagram) < 0)
+          {
+             result = -1;
+
+             break;
+          }
+
+          sentCount = 1;
+       }
+
+       datagram += sentCount;
+    }
+
+    for (i = 0; i < host -> sendBatchDataCount; ++ i)
+    {
+       enet_protocol_remove_sent_unreliable_commands (host -> sendBatchData [i].peer);
+
+       host -> sendBatchData [i].peer = NULL;
+    }
+
+    if (result >= 0)
+    {
+       for (i = 0; i < host -> sendBatchCount; ++ i)
+         host -> totalSentData += host -> sendBatch [i].dataLength;
+
+       host -> totalSentPackets += host -> sendBatchDataCount;
+    }
+
+    host -> sendBatchCount = 0;
+    host -> sendBatchDataCount = 0;
+    host -> sendBatchBufferCount = 0;
+
+    return result;
+}
+
+static int
+enet_protocol_send_peer_datagrams (ENetHost * host, ENetPeer * peer)
+{
+    size_t i;
+
+    for (i = 0; i < host -> sendBatchDataCount; ++ i)
+    {
+       if (host -> sendBatchData [i].peer == peer)
+         return enet_protocol_send_datagrams (host);
+    }
+
+    return 0;
+}
+
+static int
+enet_protocol_can_coalesce (ENetHost * host, const ENetDatagram * datagram, size_t dataLength, size_t bufferCount)
+{
+    size_t segmentSize = datagram -> segmentSize ? datagram -> segmentSize : datagram -> dataLength;
+
+    return host -> sendSegmentation &&
+           dataLength > 0 &&
+           dataLength <= segmentSize &&
+           datagram -> dataLength % segmentSize == 0 &&
+           datagram -> dataLength / segmentSize < ENET_DATAGRAM_SEGMENT_MAXIMUM &&
+           datagram -> dataLength + dataLength <= ENET_DATAGRAM_DATA_MAXIMUM &&
+           datagram -> bufferCount + bufferCount <= ENET_DATAGRAM_BUFFER_MAXIMUM;
+}
+
+static void
+enet_protocol_stage_datagram (ENetHost * host, ENetPeer * peer, const enet_uint8 * headerData, enet_uint32 sendDelay, int deferFinish)
+{
+    ENetOutgoingDatagram * outgoingDatagram = & host -> sendBatchData [host -> sendBatchDataCount];
+    ENetBuffer * buffers = & host -> sendBatchBuffers [host -> sendBatchBufferCount];
+    ENetDatagram * datagram;
+    const enet_uint8 * commandsBegin = (const enet_uint8 *) host -> commands,
+                     * commandsEnd = (const enet_uint8 *) & host -> commands [host -> commandCount];
+    size_t dataLength = 0, i;
+
+    memcpy (outgoingDatagram -> headerData, headerData, host -> buffers -> dataLength);
+    memcpy (outgoingDatagram -> commands, host -> commands, host -> commandCount * sizeof (ENetProtocol));
+
+    for (i = 0; i < host -> bufferCount; ++ i)
+    {
+       const enet_uint8 * data = (const enet_uint8 *) host -> buffers [i].data;
+
+       if (data == headerData)
+         buffers [i].data = outgoingDatagram -> headerData;
+       else
+       if (data >= commandsBegin && data < commandsEnd)
+         buffers [i].data = (enet_uint8 *) outgoingDatagram -> commands + (data - commandsBegin);
+       else
+         buffers [i].data = host -> buffers [i].data;
+
+       buffers [i].dataLength = host -> buffers [i].dataLength;
+
+       dataLength += buffers [i].dataLength;
+    }
+
+    outgoingDatagram -> peer = peer;
+    outgoingDatagram -> buffers = buffers;
+    outgoingDatagram -> bufferCount = host -> bufferCount;
+    outgoingDatagram -> datagram = NULL;
+
+    ++ host -> sendBatchDataCount;
+    host -> sendBatchBufferCount += host -> bufferCount;
+
+    if (! deferFinish &&
+        host -> sendBatchCount > 0 &&
+        outgoingDatagram [-1].peer == peer &&
+        outgoingDatagram [-1].datagram == NULL)
+    {
+       datagram = & host -> sendBatch [host -> sendBatchCount - 1];
+
+       if (datagram -> sendDelay == sendDelay &&
+           enet_protocol_can_coalesce (host, datagram, dataLength, host -> bufferCount))
+       {
+          if (datagram -> segmentSize == 0)
+            datagram -> segmentSize = datagram -> dataLength;
+
+          datagram -> bufferCount += host -> bufferCount;
+          datagram -> dataLength += dataLength;
+
+          return;
+       }
+    }
+
+    datagram = & host -> sendBatch [host -> sendBatchCount ++];
+
+    datagram -> address = peer -> address;
+    datagram -> buffers = buffers;
+    datagram -> bufferCount = host -> bufferCount;
+    datagram -> dataLength = dataLength;
+    datagram -> segmentSize = 0;
+    datagram -> sendDelay = sendDelay;
+
+    if (deferFinish)
+    {
+       outgoingDatagram -> datagram = datagram;
+
+       ++ host -> sendJobCount;
+    }
+}
+
+/** Returns the sent time an acknowledgement echoes back to the peer, advanced by however long
+    the acknowledgement was held so that the peer's round trip time measurement excludes it.
+*/
+static enet_uint16
+enet_protocol_acknowledgement_sent_time (ENetPeer * peer, ENetAcknowledgement * acknowledgement)
+{
+    return (enet_uint16) (acknowledgement -> sentTime + ENET_TIME_DIFFERENCE (peer -> host -> serviceTime, acknowledgement -> queueTime));
+}
+
+/** Builds an acknowledgement range starting at the given acknowledgement, absorbing the run of
+    acknowledgements queued after it on the same channel whose sequence numbers fall within the
+    range's mask.  The absorbed acknowledgements are freed, and the range carries the sent time
+    of the most recently received one.
+    @returns the first acknowledgement not absorbed into the range
+*/
+static ENetListIterator
+enet_protocol_gather_acknowledgement_range (ENetPeer * peer, ENetAcknowledgement * acknowledgement, ENetProtocol * command)
+{
+    ENetListIterator currentAcknowledgement = enet_list_next (& acknowledgement -> acknowledgementList);
+    enet_uint16 reliableSequenceNumber = acknowledgement -> command.header.reliableSequenceNumber,
+                sentTime = enet_protocol_acknowledgement_sent_time (peer, acknowledgement);
+    enet_uint32 receivedMask = 0;
+
+    while (currentAcknowledgement != enet_list_end (& peer -> acknowledgements))
+    {
+       ENetAcknowledgement * nextAcknowledgement = (ENetAcknowledgement *) currentAcknowledgement;
+       enet_uint16 offset = nextAcknowledgement -> command.header.reliableSequenceNumber - reliableSequenceNumber;
+
+       if (nextAcknowledgement -> command.header.channelID != acknowledgement -> command.header.channelID ||
+           offset > 32)
+         break;
+
+       if (offset > 0)
+         receivedMask |= (enet_uint32) 1 << (offset - 1);
+
+       sentTime = enet_protocol_acknowledgement_sent_time (peer, nextAcknowledgement);
+
+       currentAcknowledgement = enet_list_next (currentAcknowledgement);
+
+       enet_list_remove (& nextAcknowledgement -> acknowledgementList);
+       enet_pool_free (& peer -> host -> acknowledgementPool, nextAcknowledgement);
+
+       -- peer -> acknowledgementCount;
+    }
+
+    command -> header.command = ENET_PROTOCOL_COMMAND_ACKNOWLEDGE_RANGE;
+    command -> header.channelID = acknowledgement -> command.header.channelID;
+    command -> header.reliableSequenceNumber = ENET_HOST_TO_NET_16 (reliableSequenceNumber);
+    command -> acknowledgeRange.receivedReliableSequenceNumber = ENET_HOST_TO_NET_16 (reliableSequenceNumber);
+    command -> acknowledgeRange.receivedSentTime = ENET_HOST_TO_NET_16 (sentTime);
+    command -> acknowledgeRange.receivedMask = ENET_HOST_TO_NET_32 (receivedMask);
+
+    return currentAcknowledgement;
+}
+
+static int
+enet_protocol_should_send_acknowledgements (ENetHost * host, ENetPeer * peer)
+{
+    ENetAcknowledgement * acknowledgement;
+
+    if (peer -> acknowledgementDelay == 0 ||
+        (peer -> state != ENET_PEER_STATE_CONNECTED && peer -> state != ENET_PEER_STATE_DISCONNECT_LATER) ||
+        ! enet_list_empty (& peer -> outgoingReliableCommands) ||
+        ! enet_list_empty (& peer -> outgoingUnreliableCommands))
+      return 1;
+
+    acknowledgement = (ENetAcknowledgement *) enet_list_front (& peer -> acknowledgements);
+    if (ENET_TIME_DIFFERENCE (host -> serviceTime, acknowledgement -> queueTime) >= peer -> acknowledgementDelay)
+      return 1;
+
+    return peer -> acknowledgementThreshold != 0 && peer -> acknowledgementCount >= peer -> acknowledgementThreshold;
+}
+
+static void
+enet_protocol_send_acknowledgements (ENetHost * host, ENetPeer * peer)
+{
+    ENetProtocol * command = & host -> commands [host -> commandCount];
+    ENetBuffer * buffer = & host -> buffers [host -> bufferCount];
+    ENetAcknowledgement * acknowledgement;
+    ENetListIterator currentAcknowledgement;
+    enet_uint16 reliableSequenceNumber;
+ 
+    currentAcknowledgement = enet_list_begin (& peer -> acknowledgements);
+         
+    while (currentAcknowledgement != enet_list_end (& peer -> acknowledgements))
+    {
+       if (command >= & host -> commands [sizeof (host -> commands) / sizeof (ENetProtocol)] ||
+           buffer >= & host -> buffers [sizeof (host -> buffers) / sizeof (ENetBuffer)] ||
+           peer -> mtu - host -> packetSize < sizeof (ENetProtocolAcknowledge))
+       {
+          host -> continueSending = 1;
+
+          break;
+       }
+
+       acknowledgement = (ENetAcknowledgement *) currentAcknowledgement;
+ 
+       if (peer -> acknowledgeRanges && acknowledgement -> command.header.channelID < peer -> channelCount)
+       {
+          if (peer -> mtu - host -> packetSize < sizeof (ENetProtocolAcknowledgeRange))
+          {
+             host -> continueSending = 1;
+
+             break;
+          }
+
+          currentAcknowledgement = enet_protocol_gather_acknowledgement_range (peer, acknowledgement, command);
+
+          buffer -> data = command;
+          buffer -> dataLength = sizeof (ENetProtocolAcknowledgeRange);
+
+          host -> packetSize += buffer -> dataLength;
+
+          enet_list_remove (& acknowledgement -> acknowledgementList);
+          enet_pool_free (& peer -> host -> acknowledgementPool, acknowledgement);
+
+          -- peer -> acknowledgementCount;
+
+          ++ command;
+          ++ buffer;
+
+          continue;
+       }
+
+       currentAcknowledgement = enet_list_next (currentAcknowledgement);
+
+       buffer -> data = command;
+       buffer -> dataLength = sizeof (ENetProtocolAcknowledge);
+
+       host -> packetSize += buffer -> dataLength;
+
+       reliableSequenceNumber = ENET_HOST_TO_NET_16 (acknowledgement -> command.header.reliableSequenceNumber);
+  
+       command -> header.command = ENET_PROTOCOL_COMMAND_ACKNOWLEDGE;
+       command -> header.channelID = acknowledgement -> command.header.channelID;
+       command -> header.reliableSequenceNumber = reliableSequenceNumber;
+       command -> acknowledge.receivedReliableSequenceNumber = reliableSequenceNumber;
+       command -> acknowledge.receivedSentTime = ENET_HOST_TO_NET_16 (enet_protocol_acknowledgement_sent_time (peer, acknowledgement));
+  
+       if ((acknowledgement -> command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_DISCONNECT)
+         enet_protocol_dispatch_state (host, peer, ENET_PEER_STATE_ZOMBIE);
+
+       enet_list_remove (& acknowledgement -> acknowledgementList);
+       enet_pool_free (& peer -> host -> acknowledgementPool, acknowledgement);
+
+       -- peer -> acknowledgementCount;
+
+       ++ command;
+       ++ buffer;
+    }
+
+    host -> commandCount = command - host -> commands;
+    host -> bufferCount = buffer - host -> buffers;
+}
+
+static void
+enet_protocol_send_unreliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
+{
+    ENetProtocol * command = & host -> commands [host -> commandCount];
+    ENetBuffer * buffer = & host -> buffers [host -> bufferCount];
+    ENetOutgoingCommand * outgoingCommand;
+    ENetListIterator currentCommand;
+    size_t dataBufferCount = 0;
+
+    currentCommand = enet_list_begin (& peer -> outgoingUnreliableCommands);
+    
+    while (currentCommand != enet_list_end (& peer -> outgoingUnreliableCommands))
+    {
+       size_t commandSize;
+
+       outgoingCommand = (ENetOutgoingCommand *) currentCommand;
+       commandSize = commandSizes [outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK];
+
+       if (command >= & host -> commands [sizeof (host -> commands) / sizeof (ENetProtocol)] ||
+           buffer + 1 >= & host -> buffers [sizeof (host -> buffers) / sizeof (ENetBuffer)] ||
+           peer -> mtu - host -> packetSize < commandSize ||
+           (outgoingCommand -> packet != NULL &&
+             peer -> mtu - host -> packetSize < commandSize + outgoingCommand -> fragmentLength))
+       {
+          host -> continueSending = 1;
+
+          break;
+       }
+
+       if (outgoingCommand -> packet != NULL)
+       {
+          dataBufferCount = enet_packet_gather (outgoingCommand -> packet,
+                                                outgoingCommand -> fragmentOffset,
+                                                outgoingCommand -> fragmentLength,
+                                                buffer + 1,
+                                                & host -> buffers [sizeof (host -> buffers) / sizeof (ENetBuffer)] - (buffer + 1));
+          if (dataBufferCount == 0)
+          {
+             host -> continueSending = 1;
+
+             break;
+          }
+       }
+
+       currentCommand = enet_list_next (currentCommand);
+
+       if (outgoingCommand -> packet != NULL && outgoingCommand -> fragmentOffset == 0)
        {
           peer -> packetThrottleCounter += ENET_PEER_PACKET_THROTTLE_COUNTER;
           peer -> packetThrottleCounter %= ENET_PEER_PACKET_THROTTLE_SCALE;
@@ -1344,13 +1956,11 @@ enet_protocol_send_unreliable_outgoing_commands (ENetHost * host, ENetPeer * pee
                          unreliableSequenceNumber = outgoingCommand -> unreliableSequenceNumber;
              for (;;)
              {
-                -- outgoingCommand -> packet -> referenceCount;
-
-                if (outgoingCommand -> packet -> referenceCount == 0)
+                if (enet_packet_remove_reference (outgoingCommand -> packet) == 0)
                   enet_packet_destroy (outgoingCommand -> packet);
          
                 enet_list_remove (& outgoingCommand -> outgoingCommandList);
-                enet_free (outgoingCommand);
+                enet_peer_free_outgoing_command (peer, outgoingCommand);
 
                 if (currentCommand == enet_list_end (& peer -> outgoingUnreliableCommands))
                   break;
@@ -1378,17 +1988,14 @@ enet_protocol_send_unreliable_outgoing_commands (ENetHost * host, ENetPeer * pee
 
        if (outgoingCommand -> packet != NULL)
        {
-          ++ buffer;
-          
-          buffer -> data = outgoingCommand -> packet -> data + outgoingCommand -> fragmentOffset;
-          buffer -> dataLength = outgoingCommand -> fragmentLength;
+          buffer += dataBufferCount;
 
-          host -> packetSize += buffer -> dataLength;
+          host -> packetSize += outgoingCommand -> fragmentLength;
 
           enet_list_insert (enet_list_end (& peer -> sentUnreliableCommands), outgoingCommand);
        }
        else
-         enet_free (outgoingCommand);
+         enet_peer_free_outgoing_command (peer, outgoingCommand);
 
        ++ command;
        ++ buffer;
@@ -1401,7 +2008,11 @@ enet_protocol_send_unreliable_outgoing_commands (ENetHost * host, ENetPeer * pee
         enet_list_empty (& peer -> outgoingReliableCommands) &&
         enet_list_empty (& peer -> outgoingUnreliableCommands) && 
         enet_list_empty (& peer -> sentReliableCommands))
-      enet_peer_disconnect (peer, peer -> eventData);
+    {
+       enet_protocol_send_peer_datagrams (host, peer);
+
+       enet_peer_disconnect (peer, peer -> eventData);
+    }
 }
 
 static int
@@ -1431,13 +2042,23 @@ enet_protocol_check_timeouts (ENetHost * host, ENetPeer * peer, ENetEvent * even
                (outgoingCommand -> roundTripTimeout >= outgoingCommand -> roundTripTimeoutLimit &&
                  ENET_TIME_DIFFERENCE (host -> serviceTime, peer -> earliestTimeout) >= peer -> timeoutMinimum)))
        {
+          enet_protocol_send_peer_datagrams (host, peer);
+
           enet_protocol_notify_disconnect (host, peer, event);
 
           return 1;
        }
 
        if (outgoingCommand -> packet != NULL)
-         peer -> reliableDataInTransit -= outgoingCommand -> fragmentLength;
+       {
+          peer -> reliableDataInTransit -= outgoingCommand -> fragmentLength;
+
+          if (host -> congestionControl.onLoss != NULL)
+            (* host -> congestionControl.onLoss) (host -> congestionControl.context, peer, outgoingCommand -> fragmentLength);
+       }
+
+       outgoingCommand -> isInTransit = 0;
+       outgoingCommand -> laterAcknowledgements = 0;
           
        ++ peer -> packetsLost;
        ++ peer -> totalPacketsLost;
@@ -1458,6 +2079,22 @@ enet_protocol_check_timeouts (ENetHost * host, ENetPeer * peer, ENetEvent * even
     return 0;
 }
 
+/** Returns how much reliable data may be in transit to a peer.  The packet throttle keeps running
+    for unreliable packets while a congestion controller is installed, but the reliable window then
+    follows the controller's congestion window and only the bandwidth limit of the throttle.
+*/
+static enet_uint32
+enet_protocol_reliable_window (ENetPeer * peer)
+{
+    enet_uint32 packetThrottle = peer -> host -> congestionControl.onAcknowledge != NULL ? peer -> packetThrottleLimit : peer -> packetThrottle,
+                windowSize = (packetThrottle * peer -> windowSize) / ENET_PEER_PACKET_THROTTLE_SCALE;
+
+    if (windowSize > peer -> congestionWindow)
+      windowSize = peer -> congestionWindow;
+
+    return windowSize;
+}
+
 static int
 enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
 {
@@ -1467,7 +2104,7 @@ enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
     ENetListIterator currentCommand;
     ENetChannel *channel;
     enet_uint16 reliableWindow;
-    size_t commandSize;
+    size_t commandSize, dataBufferCount = 0;
     int windowExceeded = 0, windowWrap = 0, canPing = 1;
 
     currentCommand = enet_list_begin (& peer -> outgoingReliableCommands);
@@ -1499,8 +2136,8 @@ enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
        {
           if (! windowExceeded)
           {
-             enet_uint32 windowSize = (peer -> packetThrottle * peer -> windowSize) / ENET_PEER_PACKET_THROTTLE_SCALE;
-             
+             enet_uint32 windowSize = enet_protocol_reliable_window (peer);
+
              if (peer -> reliableDataInTransit + outgoingCommand -> fragmentLength > ENET_MAX (windowSize, peer -> mtu))
                windowExceeded = 1;
           }
@@ -1526,15 +2163,45 @@ enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
           break;
        }
 
+       if (outgoingCommand -> streamFragments > 0)
+       {
+          outgoingCommand = enet_peer_stream_next_fragment (peer, outgoingCommand);
+          if (outgoingCommand == NULL)
+            break;
+
+          currentCommand = & outgoingCommand -> outgoingCommandList;
+       }
+
+       if (outgoingCommand -> packet != NULL)
+       {
+          dataBufferCount = enet_packet_gather (outgoingCommand -> packet,
+                                                outgoingCommand -> fragmentOffset,
+                                                outgoingCommand -> fragmentLength,
+                                                buffer + 1,
+                                                & host -> buffers [sizeof (host -> buffers) / sizeof (ENetBuffer)] - (buffer + 1));
+          if (dataBufferCount == 0)
+          {
+             host -> continueSending = 1;
+
+             break;
+          }
+       }
+
        currentCommand = enet_list_next (currentCommand);
 
-       if (channel != NULL && outgoingCommand -> sendAttempts < 1)
+       if (outgoingCommand -> sendAttempts < 1)
        {
-          channel -> usedReliableWindows |= 1 << reliableWindow;
-          ++ channel -> reliableWindows [reliableWindow];
+          if (channel != NULL)
+          {
+             channel -> usedReliableWindows |= 1 << reliableWindow;
+             ++ channel -> reliableWindows [reliableWindow];
+          }
+
+          enet_peer_index_sent_reliable_command (peer, outgoingCommand);
        }
 
        ++ outgoingCommand -> sendAttempts;
+       outgoingCommand -> isInTransit = 1;
  
        if (outgoingCommand -> roundTripTimeout == 0)
        {
@@ -1560,14 +2227,14 @@ enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
 
        if (outgoingCommand -> packet != NULL)
        {
-          ++ buffer;
-          
-          buffer -> data = outgoingCommand -> packet -> data + outgoingCommand -> fragmentOffset;
-          buffer -> dataLength = outgoingCommand -> fragmentLength;
+          buffer += dataBufferCount;
 
           host -> packetSize += outgoingCommand -> fragmentLength;
 
           peer -> reliableDataInTransit += outgoingCommand -> fragmentLength;
+
+          if (host -> congestionControl.onSend != NULL)
+            (* host -> congestionControl.onSend) (host -> congestionControl.context, peer, outgoingCommand -> fragmentLength);
        }
 
        ++ peer -> packetsSent;
@@ -1583,58 +2250,355 @@ enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
     return canPing;
 }
 
+static enet_uint32
+enet_protocol_pacing_rate (ENetPeer * peer)
+{
+    enet_uint32 windowSize, rate;
+
+    if (peer -> pacingRate != 0)
+      return peer -> pacingRate;
+
+    windowSize = enet_protocol_reliable_window (peer);
+
+    rate = ENET_MAX (windowSize, peer -> mtu) * 1000 / ENET_MAX (peer -> roundTripTime, 1);
+    rate += rate / 4;
+
+    if (peer -> incomingBandwidth != 0 && rate > peer -> incomingBandwidth)
+      rate = peer -> incomingBandwidth;
+
+    return rate;
+}
+
+/** Returns how many bytes a paced peer's token bucket is short of allowing another datagram,
+    which with kernel release times is however far the bucket has run beyond the pacing horizon.
+*/
+static enet_uint32
+enet_protocol_pacing_deficit (ENetHost * host, ENetPeer * peer, enet_uint32 rate)
+{
+    enet_uint32 deficit, horizon;
+
+    if (peer -> pacingTokens > 0)
+      return 0;
+
+    deficit = (enet_uint32) (- peer -> pacingTokens) + 1;
+
+    if (host -> sendReleaseTime)
+    {
+       horizon = rate / 1000 * ENET_PEER_PACING_HORIZON;
+
+       deficit = deficit > horizon ? deficit - horizon : 0;
+    }
+
+    return deficit;
+}
+
+static enet_uint32
+enet_protocol_pacing_burst (ENetPeer * peer, enet_uint32 rate)
+{
+    return ENET_MAX (rate / 1000 * ENET_PEER_PACING_BURST_TIME, 2 * peer -> mtu);
+}
+
+static int
+enet_protocol_pacing_allows (ENetHost * host, ENetPeer * peer)
+{
+    enet_uint32 rate, elapsed, refill, burst;
+
+    if (! peer -> pacing)
+      return 1;
+
+    rate = enet_protocol_pacing_rate (peer);
+    burst = enet_protocol_pacing_burst (peer, rate);
+
+    if (ENET_TIME_LESS (peer -> pacingTime, host -> serviceTime))
+    {
+       elapsed = ENET_TIME_DIFFERENCE (host -> serviceTime, peer -> pacingTime);
+       if (elapsed >= 1000)
+         refill = burst;
+       else
+         refill = rate / 1000 * elapsed + rate % 1000 * elapsed / 1000;
+
+       if (refill >= burst || peer -> pacingTokens + (int) refill >= (int) burst)
+         peer -> pacingTokens = (int) burst;
+       else
+         peer -> pacingTokens += (int) refill;
+
+       peer -> pacingTime = host -> serviceTime;
+    }
+
+    return enet_protocol_pacing_deficit (host, peer, rate) == 0;
+}
+
+static enet_uint32
+enet_protocol_pacing_delay (ENetHost * host, ENetPeer * peer)
+{
+    if (! host -> sendReleaseTime || peer -> pacingTokens >= 0)
+      return 0;
+
+    return (enet_uint32) (- peer -> pacingTokens) * 1000 / ENET_MAX (enet_protocol_pacing_rate (peer) / 1000, 1);
+}
+
+/** Charges a datagram carrying data commands to a paced peer's token bucket.  The bucket never
+    runs further behind than a burst beyond the point at which it stops sending.
+*/
+static void
+enet_protocol_pacing_debit (ENetHost * host, ENetPeer * peer, size_t packetSize)
+{
+    enet_uint32 rate = enet_protocol_pacing_rate (peer),
+                limit = enet_protocol_pacing_burst (peer, rate);
+
+    if (host -> sendReleaseTime)
+      limit += rate / 1000 * ENET_PEER_PACING_HORIZON;
+
+    if (peer -> pacingTokens - (int) packetSize < - (int) limit)
+      peer -> pacingTokens = - (int) limit;
+    else
+      peer -> pacingTokens -= (int) packetSize;
+}
+
+static void
+enet_protocol_schedule_peer (ENetHost * host, ENetPeer * peer)
+{
+    enet_uint32 deadline, slot;
+
+    if (! enet_list_empty (& peer -> sentReliableCommands))
+      deadline = peer -> nextTimeout;
+    else
+      deadline = peer -> lastReceiveTime + peer -> pingInterval;
+
+    if (! enet_list_empty (& peer -> acknowledgements))
+    {
+       enet_uint32 acknowledgementDeadline = ((ENetAcknowledgement *) enet_list_front (& peer -> acknowledgements)) -> queueTime + peer -> acknowledgementDelay;
+
+       if (ENET_TIME_LESS (acknowledgementDeadline, deadline))
+         deadline = acknowledgementDeadline;
+    }
+
+    if (peer -> pacing &&
+        (! enet_list_empty (& peer -> outgoingReliableCommands) ||
+          ! enet_list_empty (& peer -> outgoingUnreliableCommands)))
+    {
+       enet_uint32 rate = enet_protocol_pacing_rate (peer),
+                   deficit = enet_protocol_pacing_deficit (host, peer, rate);
+
+       if (deficit > 0)
+       {
+          enet_uint32 pacingDeadline = host -> serviceTime + 1 + deficit / ENET_MAX (rate / 1000, 1);
+
+          if (ENET_TIME_LESS (pacingDeadline, deadline))
+            deadline = pacingDeadline;
+       }
+    }
+
+    slot = ENET_TIME_LESS (host -> timerTime, deadline) ? deadline : host -> timerTime + 1;
+
+    enet_peer_deactivate (peer);
+
+    enet_list_insert (enet_list_end (& host -> timerWheel [slot % ENET_HOST_TIMER_WHEEL_SIZE]), & peer -> activeList);
+
+    peer -> timerDeadline = deadline;
+    peer -> isScheduled = 1;
+
+    if (! host -> timerDeadlineValid || ENET_TIME_LESS (deadline, host -> timerDeadline))
+    {
+        host -> timerDeadline = deadline;
+        host -> timerDeadlineValid = 1;
+    }
+}
+
+static void
+enet_protocol_schedule_active_peers (ENetHost * host)
+{
+    ENetListIterator currentActive = enet_list_begin (& host -> activePeers);
+
+    while (currentActive != enet_list_end (& host -> activePeers))
+    {
+       ENetPeer * peer = ENET_PEER_FROM_ACTIVE_LIST (currentActive);
+
+       currentActive = enet_list_next (currentActive);
+
+       if (peer -> state == ENET_PEER_STATE_DISCONNECTED ||
+           peer -> state == ENET_PEER_STATE_ZOMBIE)
+         enet_peer_deactivate (peer);
+       else
+         enet_protocol_schedule_peer (host, peer);
+    }
+}
+
+static void
+enet_protocol_fire_timers (ENetHost * host)
+{
+    enet_uint32 slotCount, slot;
+
+    if (host -> timerTime == host -> serviceTime)
+      return;
+
+    if (ENET_TIME_LESS (host -> serviceTime, host -> timerTime))
+    {
+       /* The clock moved backwards, so the deadlines hashed into the wheel no longer map onto
+          the slots ahead of it.  Service every scheduled peer now; the send loop will hash them
+          again relative to the new time. */
+       for (slot = 0; slot < ENET_HOST_TIMER_WHEEL_SIZE; ++ slot)
+       {
+          ENetList * timers = & host -> timerWheel [slot];
+
+          while (! enet_list_empty (timers))
+            enet_peer_activate (ENET_PEER_FROM_ACTIVE_LIST (enet_list_begin (timers)));
+       }
+
+       host -> timerTime = host -> serviceTime;
+       host -> timerDeadlineValid = 0;
+       return;
+    }
+
+    slotCount = ENET_TIME_DIFFERENCE (host -> serviceTime, host -> timerTime);
+    if (slotCount > ENET_HOST_TIMER_WHEEL_SIZE)
+      slotCount = ENET_HOST_TIMER_WHEEL_SIZE;
+
+    for (slot = 1; slot <= slotCount; ++ slot)
+    {
+       ENetList * timers = & host -> timerWheel [(host -> timerTime + slot) % ENET_HOST_TIMER_WHEEL_SIZE];
+       ENetListIterator currentTimer = enet_list_begin (timers);
+
+       while (currentTimer != enet_list_end (timers))
+       {
+          ENetPeer * peer = ENET_PEER_FROM_ACTIVE_LIST (currentTimer);
+
+          currentTimer = enet_list_next (currentTimer);
+
+          if (ENET_TIME_LESS_EQUAL (peer -> timerDeadline, host -> serviceTime))
+            enet_peer_activate (peer);
+       }
+    }
+
+    host -> timerTime = host -> serviceTime;
+}
+
+static enet_uint32
+enet_protocol_next_deadline (ENetHost * host)
+{
+    enet_uint32 slot;
+
+    if (host -> timerDeadlineValid && ENET_TIME_LESS (host -> timerTime, host -> timerDeadline))
+      return host -> timerDeadline;
+
+    host -> timerDeadlineValid = 0;
+
+    for (slot = 1; slot <= ENET_HOST_TIMER_WHEEL_SIZE; ++ slot)
+    {
+       ENetList * timers = & host -> timerWheel [(host -> timerTime + slot) % ENET_HOST_TIMER_WHEEL_SIZE];
+       ENetListIterator currentTimer;
+
+       if (host -> timerDeadlineValid &&
+           ENET_TIME_LESS_EQUAL (host -> timerDeadline, host -> timerTime + slot))
+         break;
+
+       for (currentTimer = enet_list_begin (timers);
+            currentTimer != enet_list_end (timers);
+            currentTimer = enet_list_next (currentTimer))
+       {
+          ENetPeer * peer = ENET_PEER_FROM_ACTIVE_LIST (currentTimer);
+
+          if (! host -> timerDeadlineValid || ENET_TIME_LESS (peer -> timerDeadline, host -> timerDeadline))
+          {
+             host -> timerDeadline = peer -> timerDeadline;
+             host -> timerDeadlineValid = 1;
+          }
+       }
+    }
+
+    return host -> timerDeadlineValid ? host -> timerDeadline : host -> timerTime + ENET_TIME_OVERFLOW;
+}
+
 static int
 enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int checkForTimeouts)
 {
     enet_uint8 headerData [sizeof (ENetProtocolHeader) + sizeof (enet_uint32)];
     ENetProtocolHeader * header = (ENetProtocolHeader *) headerData;
     ENetPeer * currentPeer;
+    ENetListIterator currentActive;
+    ENetOutgoingDatagram * outgoingDatagram;
     int sentLength;
-    size_t shouldCompress = 0;
+    size_t shouldCompress = 0, acknowledgementSize;
+    enet_uint32 sendDelay;
+    int deferCompression, deferFinish;
  
+    if (host -> group != NULL)
+      enet_host_group_receive_broadcasts (host);
+
+    if (host -> submissions != NULL)
+      enet_host_drain_submissions (host);
+
+    enet_protocol_fire_timers (host);
+
+    deferCompression = host -> sendWorkerCompression && host -> compressor.context != NULL && host -> compressor.compress != NULL;
+    deferFinish = deferCompression || host -> checksum != NULL;
+    if (host -> sendWorkerCount == 0 || host -> sendBatch == NULL)
+      deferCompression = deferFinish = 0;
+
     host -> continueSending = 1;
 
     while (host -> continueSending)
     for (host -> continueSending = 0,
-           currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+           currentActive = enet_list_begin (& host -> activePeers);
+         currentActive != enet_list_end (& host -> activePeers);
+        )
     {
-        if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED ||
-            currentPeer -> state == ENET_PEER_STATE_ZOMBIE)
+        currentPeer = ENET_PEER_FROM_ACTIVE_LIST (currentActive);
+
+        currentActive = enet_list_next (currentActive);
+
+        if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED)
+        {
+          enet_peer_deactivate (currentPeer);
+
           continue;
+        }
 
+        if (currentPeer -> state == ENET_PEER_STATE_ZOMBIE)
+          continue;
+
+    nextDatagram:
         host -> headerFlags = 0;
         host -> commandCount = 0;
         host -> bufferCount = 1;
         host -> packetSize = sizeof (ENetProtocolHeader);
 
-        if (! enet_list_empty (& currentPeer -> acknowledgements))
+        if (! enet_list_empty (& currentPeer -> acknowledgements) &&
+            enet_protocol_should_send_acknowledgements (host, currentPeer))
           enet_protocol_send_acknowledgements (host, currentPeer);
 
+        acknowledgementSize = host -> packetSize;
+
         if (checkForTimeouts != 0 &&
             ! enet_list_empty (& currentPeer -> sentReliableCommands) &&
             ENET_TIME_GREATER_EQUAL (host -> serviceTime, currentPeer -> nextTimeout) &&
             enet_protocol_check_timeouts (host, currentPeer, event) == 1)
         {
             if (event != NULL && event -> type != ENET_EVENT_TYPE_NONE)
+            {
+              enet_protocol_send_datagrams (host);
+
               return 1;
+            }
             else
               continue;
         }
 
-        if ((enet_list_empty (& currentPeer -> outgoingReliableCommands) ||
-              enet_protocol_send_reliable_outgoing_commands (host, currentPeer)) &&
-            enet_list_empty (& currentPeer -> sentReliableCommands) &&
-            ENET_TIME_DIFFERENCE (host -> serviceTime, currentPeer -> lastReceiveTime) >= currentPeer -> pingInterval &&
-            currentPeer -> mtu - host -> packetSize >= sizeof (ENetProtocolPing))
-        { 
-            enet_peer_ping (currentPeer);
-            enet_protocol_send_reliable_outgoing_commands (host, currentPeer);
+        if (enet_protocol_pacing_allows (host, currentPeer))
+        {
+            if ((enet_list_empty (& currentPeer -> outgoingReliableCommands) ||
+                  enet_protocol_send_reliable_outgoing_commands (host, currentPeer)) &&
+                enet_list_empty (& currentPeer -> sentReliableCommands) &&
+                ENET_TIME_DIFFERENCE (host -> serviceTime, currentPeer -> lastReceiveTime) >= currentPeer -> pingInterval &&
+                currentPeer -> mtu - host -> packetSize >= sizeof (ENetProtocolPing))
+            { 
+                enet_peer_ping (currentPeer);
+                enet_protocol_send_reliable_outgoing_commands (host, currentPeer);
+            }
+                          
+            if (! enet_list_empty (& currentPeer -> outgoingUnreliableCommands))
+              enet_protocol_send_unreliable_outgoing_commands (host, currentPeer);
         }
-                      
-        if (! enet_list_empty (& currentPeer -> outgoingUnreliableCommands))
-          enet_protocol_send_unreliable_outgoing_commands (host, currentPeer);
 
         if (host -> commandCount == 0)
           continue;
@@ -1679,14 +2643,16 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
         else
           host -> buffers -> dataLength = (size_t) & ((ENetProtocolHeader *) 0) -> sentTime;
 
+        outgoingDatagram = host -> sendBatch != NULL ? & host -> sendBatchData [host -> sendBatchDataCount] : NULL;
+
         shouldCompress = 0;
-        if (host -> compressor.context != NULL && host -> compressor.compress != NULL)
+        if (! deferCompression && host -> compressor.context != NULL && host -> compressor.compress != NULL)
         {
             size_t originalSize = host -> packetSize - sizeof(ENetProtocolHeader),
                    compressedSize = host -> compressor.compress (host -> compressor.context,
                                         & host -> buffers [1], host -> bufferCount - 1,
                                         originalSize,
-                                        host -> packetData [1],
+                                        outgoingDatagram != NULL ? outgoingDatagram -> packetData : host -> packetData [1],
                                         originalSize);
             if (compressedSize > 0 && compressedSize < originalSize)
             {
@@ -1706,18 +2672,51 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
             enet_uint32 * checksum = (enet_uint32 *) & headerData [host -> buffers -> dataLength];
             * checksum = currentPeer -> outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID ? currentPeer -> connectID : 0;
             host -> buffers -> dataLength += sizeof (enet_uint32);
-            * checksum = host -> checksum (host -> buffers, host -> bufferCount);
+            if (! deferFinish)
+              * checksum = host -> checksum (host -> buffers, host -> bufferCount);
         }
 
-        if (shouldCompress > 0)
+        /* A deferred checksum covers the uncompressed commands, so a datagram compressed here is
+           staged with its uncompressed buffers and only switched over once it is finished. */
+        if (shouldCompress > 0 && ! deferFinish)
         {
-            host -> buffers [1].data = host -> packetData [1];
+            host -> buffers [1].data = outgoingDatagram != NULL ? outgoingDatagram -> packetData : host -> packetData [1];
             host -> buffers [1].dataLength = shouldCompress;
             host -> bufferCount = 2;
         }
 
         currentPeer -> lastSendTime = host -> serviceTime;
 
+        if (currentPeer -> pacing && host -> packetSize > acknowledgementSize)
+        {
+            sendDelay = enet_protocol_pacing_delay (host, currentPeer);
+
+            enet_protocol_pacing_debit (host, currentPeer, host -> packetSize);
+        }
+        else
+          sendDelay = 0;
+
+        if (outgoingDatagram != NULL)
+        {
+            outgoingDatagram -> compressedSize = deferFinish ? shouldCompress : 0;
+
+            enet_protocol_stage_datagram (host, currentPeer, headerData, sendDelay, deferFinish);
+
+            if (host -> sendBatchDataCount >= host -> sendBatchSize)
+            {
+                if (enet_protocol_send_datagrams (host) < 0)
+                  return -1;
+            }
+            else
+            if (host -> sendSegmentation && ! deferFinish &&
+                (! enet_list_empty (& currentPeer -> outgoingReliableCommands) ||
+                  ! enet_list_empty (& currentPeer -> outgoingUnreliableCommands)) &&
+                enet_protocol_can_coalesce (host, & host -> sendBatch [host -> sendBatchCount - 1], 1, 0))
+              goto nextDatagram;
+
+            continue;
+        }
+
         sentLength = enet_socket_send (host -> socket, & currentPeer -> address, host -> buffers, host -> bufferCount);
 
         enet_protocol_remove_sent_unreliable_commands (currentPeer);
@@ -1728,8 +2727,10 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
         host -> totalSentData += sentLength;
         host -> totalSentPackets ++;
     }
+
+    enet_protocol_schedule_active_peers (host);
    
-    return 0;
+    return enet_protocol_send_datagrams (host);
 }
 
 /** Sends any queued packets on the host specified to its designated peers.
@@ -1746,6 +2747,37 @@ enet_host_flush (ENetHost * host)
     enet_protocol_send_outgoing_commands (host, NULL, 0);
 }
 
+/** Returns the time remaining until the host next has to be serviced.
+
+    @param host host to query
+    @returns the number of milliseconds until the earliest retransmission or ping deadline of any
+    peer, 0 if the host already has work pending, or ENET_TIME_OVERFLOW if no deadline is scheduled
+    @remarks An application driving its own event loop may sleep for at most this long, or until
+    the host's socket becomes readable, before calling enet_host_service() again.
+    @ingroup host
+*/
+enet_uint32
+enet_host_next_timeout (ENetHost * host)
+{
+    enet_uint32 currentTime, deadline;
+
+    if (! enet_list_empty (& host -> dispatchQueue) ||
+        ! enet_list_empty (& host -> activePeers))
+      return 0;
+
+    deadline = enet_protocol_next_deadline (host);
+    if (! host -> timerDeadlineValid)
+      return ENET_TIME_OVERFLOW;
+
+    /* The wheel only fires once the clock has ticked past its current slot. */
+    if (ENET_TIME_LESS_EQUAL (deadline, host -> timerTime))
+      deadline = host -> timerTime + 1;
+
+    currentTime = enet_time_get ();
+
+    return ENET_TIME_LESS (currentTime, deadline) ? ENET_TIME_DIFFERENCE (deadline, currentTime) : 0;
+}
+
 /** Checks for any queued events on the host and dispatches one if available.
 
     @param host    host to check for events
@@ -1783,7 +2815,7 @@ enet_host_check_events (ENetHost * host, ENetEvent * event)
 int
 enet_host_service (ENetHost * host, ENetEvent * event, enet_uint32 timeout)
 {
-    enet_uint32 waitCondition;
+    enet_uint32 waitCondition, deadline;
 
     if (event != NULL)
     {
@@ -1896,13 +2928,21 @@ enet_host_service (ENetHost * host, ENetEvent * event, enet_uint32 timeout)
 
           waitCondition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
 
-          if (enet_socket_wait (host -> socket, & waitCondition, ENET_TIME_DIFFERENCE (timeout, host -> serviceTime)) != 0)
+          deadline = enet_protocol_next_deadline (host);
+          if (ENET_TIME_LESS_EQUAL (deadline, host -> timerTime))
+            deadline = host -> timerTime + 1;
+          if (! enet_list_empty (& host -> activePeers) || ENET_TIME_LESS (deadline, host -> serviceTime))
+            deadline = host -> serviceTime;
+          if (ENET_TIME_LESS (timeout, deadline))
+            deadline = timeout;
+
+          if (enet_socket_wait_wakeup (host -> socket, host -> submissionWakeup, & waitCondition, ENET_TIME_DIFFERENCE (deadline, host -> serviceTime)) != 0)
             return -1;
        }
        while (waitCondition & ENET_SOCKET_WAIT_INTERRUPT);
 
        host -> serviceTime = enet_time_get ();
-    } while (waitCondition & ENET_SOCKET_WAIT_RECEIVE);
+    } while ((waitCondition & ENET_SOCKET_WAIT_RECEIVE) || ENET_TIME_LESS (host -> serviceTime, timeout));
 
     return 0; 
 }
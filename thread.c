@@ -0,0 +1,374 @@
+/**
+ @file  thread.c
+ @brief ENet host I/O and send worker threads
+*/
+#define ENET_BUILDING_LIB 1
+#include "enet/enet.h"
+
+/** @defgroup thread ENet host thread functions
+    @{
+*/
+
+static void ENET_CALLBACK
+enet_host_io_thread_run (void * context)
+{
+    ENetHost * host = (ENetHost *) context;
+    size_t eventHead = host -> ioEventHead;
+
+    while (! ENET_ATOMIC_LOAD (& host -> ioThreadStop))
+    {
+       enet_uint32 waitCondition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT,
+                   timeout;
+       ENetEvent event;
+
+       enet_mutex_lock (& host -> ioMutex);
+
+       enet_host_service (host, NULL, 0);
+
+       while (eventHead - ENET_ATOMIC_LOAD (& host -> ioEventTail) <= host -> ioEventMask &&
+              enet_host_check_events (host, & event) > 0)
+       {
+          host -> ioEvents [eventHead & host -> ioEventMask] = event;
+
+          ++ eventHead;
+
+          ENET_ATOMIC_STORE (& host -> ioEventHead, eventHead);
+       }
+
+       if (eventHead - ENET_ATOMIC_LOAD (& host -> ioEventTail) > host -> ioEventMask)
+         timeout = ENET_HOST_IO_THREAD_WAIT;
+       else
+       {
+          timeout = enet_host_next_timeout (host);
+          if (host -> submissionWakeup == ENET_SOCKET_NULL && timeout > ENET_HOST_IO_THREAD_WAIT)
+            timeout = ENET_HOST_IO_THREAD_WAIT;
+       }
+
+       enet_mutex_unlock (& host -> ioMutex);
+
+       if (timeout > 0)
+         enet_socket_wait_wakeup (host -> socket, host -> submissionWakeup, & waitCondition, timeout);
+    }
+}
+
+/** Starts a thread that services a host on its own, so that acknowledgements, retransmissions
+    and timeouts are handled however rarely the application looks at the host.
+    @param host host to service
+    @param eventCapacity number of events the thread may publish before the application takes
+    them with enet_host_io_event(), rounded up to a power of two
+    @returns 0 on success, < 0 on failure, including if the host receives with
+    enet_host_receive_zero_copy() or still holds events published by a previous thread
+
+    @remarks While the thread runs, the application must not call enet_host_service(),
+    enet_host_check_events() or enet_host_flush() on the host.  It takes events with
+    enet_host_io_event() instead and sends packets with enet_peer_submit(), for which a submission
+    queue is set up if the host has none.  Any other function that uses the host or its peers must
+    be called between enet_host_io_lock() and enet_host_io_unlock().  Where supported, a wakeup is
+    enabled on the host as by enet_host_submission_wakeup(), so that the thread sends submitted
+    packets immediately; otherwise it checks for them every ENET_HOST_IO_THREAD_WAIT milliseconds.
+    The host's callbacks, such as its intercept and congestion control callbacks, run on the thread.
+*/
+int
+enet_host_io_thread_start (ENetHost * host, size_t eventCapacity)
+{
+    ENetEvent * events;
+    size_t eventCount;
+    int createdSubmissions = host -> submissions == NULL,
+        createdWakeup = host -> submissionWakeup == ENET_SOCKET_NULL;
+
+    if (host -> ioThreadRunning || host -> receiveZeroCopy ||
+        (host -> ioEvents != NULL && host -> ioEventHead != host -> ioEventTail))
+      return -1;
+
+    for (eventCount = 2; eventCount < eventCapacity; eventCount <<= 1)
+      ;
+
+    events = (ENetEvent *) enet_malloc (eventCount * sizeof (ENetEvent));
+    if (events == NULL)
+      return -1;
+
+    if (createdSubmissions && enet_host_submission_queue (host, eventCount) < 0)
+    {
+       enet_free (events);
+
+       return -1;
+    }
+
+    if (enet_mutex_create (& host -> ioMutex) < 0)
+    {
+       if (createdSubmissions)
+         enet_host_submission_queue (host, 0);
+
+       enet_free (events);
+
+       return -1;
+    }
+
+    enet_host_submission_wakeup (host, 1);
+
+    if (host -> ioEvents != NULL)
+      enet_free (host -> ioEvents);
+
+    host -> ioEvents = events;
+    host -> ioEventMask = eventCount - 1;
+    host -> ioEventHead = 0;
+    host -> ioEventTail = 0;
+    host -> ioThreadStop = 0;
+
+    if (enet_thread_create (& host -> ioThread, enet_host_io_thread_run, host) < 0)
+    {
+       enet_mutex_destroy (& host -> ioMutex);
+
+       enet_free (host -> ioEvents);
+
+       host -> ioEvents = NULL;
+
+       if (createdWakeup)
+         enet_host_submission_wakeup (host, 0);
+
+       if (createdSubmissions)
+         enet_host_submission_queue (host, 0);
+
+       return -1;
+    }
+
+    host -> ioThreadRunning = 1;
+
+    return 0;
+}
+
+/** Stops the thread servicing a host started with enet_host_io_thread_start(), and waits for it to finish.
+    @param host host to stop servicing
+    @remarks Events the thread published are kept for enet_host_io_event(), and should be taken
+    before the host is serviced with enet_host_service() again so that they are seen in order.
+*/
+void
+enet_host_io_thread_stop (ENetHost * host)
+{
+    if (! host -> ioThreadRunning)
+      return;
+
+    ENET_ATOMIC_STORE (& host -> ioThreadStop, 1);
+
+    if (host -> submissionWakeup != ENET_SOCKET_NULL)
+      enet_socket_signal_wakeup (host -> submissionWakeup);
+
+    enet_thread_join (& host -> ioThread);
+
+    enet_mutex_destroy (& host -> ioMutex);
+
+    host -> ioThreadRunning = 0;
+}
+
+/** Takes the next event published by the thread servicing a host.
+    @param host host to take the event from
+    @param event an event structure where event details will be placed if available
+    @retval > 0 if an event was taken
+    @retval 0 if no events are available
+    @retval < 0 on failure
+    @remarks Must only be called from one thread at a time.
+*/
+int
+enet_host_io_event (ENetHost * host, ENetEvent * event)
+{
+    size_t eventTail;
+
+    if (event == NULL)
+      return -1;
+
+    event -> type = ENET_EVENT_TYPE_NONE;
+    event -> peer = NULL;
+    event -> packet = NULL;
+
+    if (host -> ioEvents == NULL)
+      return 0;
+
+    eventTail = host -> ioEventTail;
+    if (eventTail == ENET_ATOMIC_LOAD (& host -> ioEventHead))
+      return 0;
+
+    * event = host -> ioEvents [eventTail & host -> ioEventMask];
+
+    ENET_ATOMIC_STORE (& host -> ioEventTail, eventTail + 1);
+
+    return 1;
+}
+
+/** Stops the thread servicing a host from using it until enet_host_io_unlock() is called.
+    @param host host to lock
+    @remarks Does nothing if the host has no I/O thread.
+*/
+void
+enet_host_io_lock (ENetHost * host)
+{
+    if (host -> ioThreadRunning)
+      enet_mutex_lock (& host -> ioMutex);
+}
+
+/** Lets the thread servicing a host use it again after enet_host_io_lock(), and wakes it so that
+    anything queued meanwhile is sent immediately.
+    @param host host to unlock
+*/
+void
+enet_host_io_unlock (ENetHost * host)
+{
+    if (! host -> ioThreadRunning)
+      return;
+
+    enet_mutex_unlock (& host -> ioMutex);
+
+    if (host -> submissionWakeup != ENET_SOCKET_NULL)
+      enet_socket_signal_wakeup (host -> submissionWakeup);
+}
+
+static void ENET_CALLBACK
+enet_host_send_worker_run (void * context)
+{
+    ENetSendWorker * worker = (ENetSendWorker *) context;
+    ENetHost * host = worker -> host;
+
+    for (;;)
+    {
+       enet_semaphore_wait (& host -> sendWorkerStart);
+
+       if (ENET_ATOMIC_LOAD (& host -> sendWorkerStop))
+         break;
+
+       enet_protocol_finish_datagrams (host, worker -> compressorContext);
+
+       enet_semaphore_post (& host -> sendWorkerDone);
+    }
+}
+
+/** Replaces the compressor contexts of a host's send workers with ones for a new compressor.
+    @param host host whose compressor is being replaced
+    @param compressor the new compressor, or NULL if compression is being disabled
+*/
+void
+enet_host_send_workers_compress (ENetHost * host, const ENetCompressor * compressor)
+{
+    ENetSendWorker * worker;
+
+    host -> sendWorkerCompression = compressor != NULL && compressor -> duplicate != NULL;
+
+    for (worker = host -> sendWorkers; worker < & host -> sendWorkers [host -> sendWorkerCount]; ++ worker)
+    {
+       if (worker -> compressorContext != NULL && host -> compressor.destroy != NULL)
+         (* host -> compressor.destroy) (worker -> compressorContext);
+
+       worker -> compressorContext = NULL;
+
+       if (host -> sendWorkerCompression)
+       {
+          worker -> compressorContext = (* compressor -> duplicate) (compressor -> context);
+          if (worker -> compressorContext == NULL)
+            host -> sendWorkerCompression = 0;
+       }
+    }
+}
+
+/** Sets the number of threads that help a host finish the datagrams of each send pass.
+    @param host host to adjust
+    @param workerCount number of worker threads; if 0, datagrams are finished by the thread
+    servicing the host alone
+    @returns 0 on success, < 0 on failure
+
+    @remarks Each send pass first assembles the datagrams for all peers on the thread servicing the
+    host, and then compresses and checksums them on that thread and the workers at once, each
+    datagram with its own output buffer and each thread with its own compressor context, before
+    sending them all in a single batch.  Send batching is enabled as by enet_host_send_batch() if
+    it is not already, and datagrams that are finished by workers are not coalesced with
+    enet_host_send_segmentation().  Compression is only done on the workers if the compressor
+    provides ENetCompressor::duplicate, as the range coder does; otherwise, the thread servicing
+    the host compresses each datagram as it assembles it and workers only compute checksums, or
+    are left idle if the host computes none.
+*/
+int
+enet_host_send_workers (ENetHost * host, size_t workerCount)
+{
+    size_t i;
+
+    if (host -> sendWorkers != NULL)
+    {
+       ENET_ATOMIC_STORE (& host -> sendWorkerStop, 1);
+
+       for (i = 0; i < host -> sendWorkerCount; ++ i)
+         enet_semaphore_post (& host -> sendWorkerStart);
+
+       for (i = 0; i < host -> sendWorkerCount; ++ i)
+         enet_thread_join (& host -> sendWorkers [i].thread);
+
+       enet_host_send_workers_compress (host, NULL);
+
+       enet_semaphore_destroy (& host -> sendWorkerStart);
+       enet_semaphore_destroy (& host -> sendWorkerDone);
+
+       enet_free (host -> sendWorkers);
+
+       host -> sendWorkers = NULL;
+       host -> sendWorkerCount = 0;
+    }
+
+    if (workerCount == 0)
+      return 0;
+
+    if (host -> sendBatch == NULL &&
+        enet_host_send_batch (host, ENET_DATAGRAM_MAXIMUM) < 0)
+      return -1;
+
+    host -> sendWorkers = (ENetSendWorker *) enet_malloc (workerCount * sizeof (ENetSendWorker));
+    if (host -> sendWorkers == NULL)
+      return -1;
+
+    if (enet_semaphore_create (& host -> sendWorkerStart) < 0)
+    {
+       enet_free (host -> sendWorkers);
+
+       host -> sendWorkers = NULL;
+
+       return -1;
+    }
+
+    if (enet_semaphore_create (& host -> sendWorkerDone) < 0)
+    {
+       enet_semaphore_destroy (& host -> sendWorkerStart);
+
+       enet_free (host -> sendWorkers);
+
+       host -> sendWorkers = NULL;
+
+       return -1;
+    }
+
+    /* Build the CRC table before workers may compute checksums concurrently. */
+    enet_crc32 (NULL, 0);
+
+    host -> sendWorkerStop = 0;
+
+    for (i = 0; i < workerCount; ++ i)
+    {
+       ENetSendWorker * worker = & host -> sendWorkers [i];
+
+       worker -> host = host;
+       worker -> compressorContext = NULL;
+
+       if (enet_thread_create (& worker -> thread, enet_host_send_worker_run, worker) < 0)
+         break;
+
+       ++ host -> sendWorkerCount;
+    }
+
+    enet_host_send_workers_compress (host, host -> compressor.context != NULL ? & host -> compressor : NULL);
+
+    if (host -> sendWorkerCount < workerCount)
+    {
+       enet_host_send_workers (host, 0);
+
+       return -1;
+    }
+
+    return 0;
+}
+
+/** @} */
+
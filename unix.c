@@ -4,12 +4,17 @@
 */
 #ifndef _WIN32
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <string.h>
@@ -48,6 +53,18 @@
 #include <sys/poll.h>
 #endif
 
+#ifdef HAS_SOCK_TXTIME
+#include <linux/net_tstamp.h>
+#endif
+
+#ifdef HAS_SOCK_FPROG
+#include <linux/filter.h>
+#endif
+
+#ifdef HAS_EVENTFD
+#include <sys/eventfd.h>
+#endif
+
 #ifndef HAS_SOCKLEN_T
 typedef int socklen_t;
 #endif
@@ -290,6 +307,63 @@ enet_socket_set_option (ENetSocket socket, ENetSocketOption option, int value)
             result = setsockopt (socket, IPPROTO_TCP, TCP_NODELAY, (char *) & value, sizeof (int));
             break;
 
+        case ENET_SOCKOPT_UDP_SEGMENT:
+#ifdef UDP_SEGMENT
+            result = setsockopt (socket, IPPROTO_UDP, UDP_SEGMENT, (char *) & value, sizeof (int));
+#endif
+            break;
+
+        case ENET_SOCKOPT_UDP_GRO:
+#ifdef UDP_GRO
+            result = setsockopt (socket, IPPROTO_UDP, UDP_GRO, (char *) & value, sizeof (int));
+#endif
+            break;
+
+        case ENET_SOCKOPT_TXTIME:
+#ifdef HAS_SOCK_TXTIME
+            if (value)
+            {
+                struct sock_txtime txTime;
+
+                memset (& txTime, 0, sizeof (struct sock_txtime));
+                txTime.clockid = CLOCK_MONOTONIC;
+
+                result = setsockopt (socket, SOL_SOCKET, SO_TXTIME, (char *) & txTime, sizeof (struct sock_txtime));
+            }
+            else
+              result = 0;
+#endif
+            break;
+
+        case ENET_SOCKOPT_REUSEPORT:
+#ifdef SO_REUSEPORT
+            result = setsockopt (socket, SOL_SOCKET, SO_REUSEPORT, (char *) & value, sizeof (int));
+#endif
+            break;
+
+        case ENET_SOCKOPT_REUSEPORT_AFFINITY:
+#if defined (HAS_SOCK_FPROG) && defined (SO_ATTACH_REUSEPORT_CBPF)
+            if (value > 0)
+            {
+                /* Select the socket of the reuseport group whose index is the IPv4 source address modulo the group size. */
+                struct sock_filter code [] =
+                {
+                    BPF_STMT (BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 12),
+                    BPF_STMT (BPF_ALU | BPF_MOD | BPF_K, 1),
+                    BPF_STMT (BPF_RET | BPF_A, 0)
+                };
+                struct sock_fprog program;
+
+                code [1].k = (enet_uint32) value;
+
+                program.len = sizeof (code) / sizeof (code [0]);
+                program.filter = code;
+
+                result = setsockopt (socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char *) & program, sizeof (struct sock_fprog));
+            }
+#endif
+            break;
+
         default:
             break;
     }
@@ -409,6 +483,164 @@ enet_socket_send (ENetSocket socket,
     return sentLength;
 }
 
+typedef union _ENetSegmentControl
+{
+    struct cmsghdr header;
+#ifdef HAS_SOCK_TXTIME
+    char data [CMSG_SPACE (sizeof (int)) + CMSG_SPACE (sizeof (__u64))];
+#else
+    char data [CMSG_SPACE (sizeof (int))];
+#endif
+} ENetSegmentControl;
+
+static int
+enet_socket_prepare_datagram (struct msghdr * msgHdr,
+                              struct sockaddr_in * sin,
+                              ENetSegmentControl * control,
+                              const ENetDatagram * datagram)
+{
+    memset (msgHdr, 0, sizeof (struct msghdr));
+    memset (sin, 0, sizeof (struct sockaddr_in));
+
+    sin -> sin_family = AF_INET;
+    sin -> sin_port = ENET_HOST_TO_NET_16 (datagram -> address.port);
+    sin -> sin_addr.s_addr = datagram -> address.host;
+
+    msgHdr -> msg_name = sin;
+    msgHdr -> msg_namelen = sizeof (struct sockaddr_in);
+    msgHdr -> msg_iov = (struct iovec *) datagram -> buffers;
+    msgHdr -> msg_iovlen = datagram -> bufferCount;
+
+    if (datagram -> segmentSize == 0 && datagram -> sendDelay == 0)
+      return 0;
+
+    memset (control, 0, sizeof (ENetSegmentControl));
+
+    if (datagram -> segmentSize > 0)
+    {
+#ifdef UDP_SEGMENT
+        struct cmsghdr * cmsg = (struct cmsghdr *) & control -> data [msgHdr -> msg_controllen];
+        enet_uint16 segmentSize = (enet_uint16) datagram -> segmentSize;
+
+        cmsg -> cmsg_level = IPPROTO_UDP;
+        cmsg -> cmsg_type = UDP_SEGMENT;
+        cmsg -> cmsg_len = CMSG_LEN (sizeof (enet_uint16));
+        memcpy (CMSG_DATA (cmsg), & segmentSize, sizeof (enet_uint16));
+
+        msgHdr -> msg_controllen += CMSG_SPACE (sizeof (enet_uint16));
+#else
+        return -1;
+#endif
+    }
+
+#ifdef HAS_SOCK_TXTIME
+    if (datagram -> sendDelay > 0)
+    {
+        struct cmsghdr * cmsg = (struct cmsghdr *) & control -> data [msgHdr -> msg_controllen];
+        struct timespec timeSpec;
+        __u64 releaseTime;
+
+        clock_gettime (CLOCK_MONOTONIC, & timeSpec);
+
+        releaseTime = (__u64) timeSpec.tv_sec * 1000000000 + timeSpec.tv_nsec + (__u64) datagram -> sendDelay * 1000;
+
+        cmsg -> cmsg_level = SOL_SOCKET;
+        cmsg -> cmsg_type = SCM_TXTIME;
+        cmsg -> cmsg_len = CMSG_LEN (sizeof (__u64));
+        memcpy (CMSG_DATA (cmsg), & releaseTime, sizeof (__u64));
+
+        msgHdr -> msg_controllen += CMSG_SPACE (sizeof (__u64));
+    }
+#endif
+
+    if (msgHdr -> msg_controllen > 0)
+      msgHdr -> msg_control = control -> data;
+
+    return 0;
+}
+
+int
+enet_socket_send_multiple (ENetSocket socket,
+                           ENetDatagram * datagrams,
+                           size_t datagramCount)
+{
+#ifdef HAS_SENDMMSG
+    struct mmsghdr msgHdrs [ENET_DATAGRAM_MAXIMUM];
+    struct sockaddr_in sins [ENET_DATAGRAM_MAXIMUM];
+    ENetSegmentControl controls [ENET_DATAGRAM_MAXIMUM];
+    size_t sentCount = 0;
+
+    while (datagramCount > 0)
+    {
+        size_t batchCount = datagramCount < ENET_DATAGRAM_MAXIMUM ? datagramCount : ENET_DATAGRAM_MAXIMUM,
+               i;
+        int sent;
+
+        for (i = 0; i < batchCount; ++ i)
+        {
+            if (enet_socket_prepare_datagram (& msgHdrs [i].msg_hdr, & sins [i], & controls [i], & datagrams [i]) < 0)
+              break;
+
+            msgHdrs [i].msg_len = 0;
+        }
+
+        if (i == 0)
+          break;
+
+        sent = sendmmsg (socket, msgHdrs, i, MSG_NOSIGNAL);
+
+        if (sent == -1)
+        {
+           if (errno != EWOULDBLOCK)
+             break;
+
+           for (i = 0; i < datagramCount; ++ i)
+             datagrams [i].dataLength = 0;
+
+           sentCount += datagramCount;
+
+           break;
+        }
+
+        for (i = 0; i < (size_t) sent; ++ i)
+          datagrams [i].dataLength = msgHdrs [i].msg_len;
+
+        sentCount += sent;
+        datagrams += sent;
+        datagramCount -= sent;
+    }
+
+    return sentCount > 0 ? (int) sentCount : -1;
+#else
+    size_t sentCount;
+
+    for (sentCount = 0; sentCount < datagramCount; ++ sentCount)
+    {
+        struct msghdr msgHdr;
+        struct sockaddr_in sin;
+        ENetSegmentControl control;
+        int sentLength;
+
+        if (enet_socket_prepare_datagram (& msgHdr, & sin, & control, & datagrams [sentCount]) < 0)
+          break;
+
+        sentLength = sendmsg (socket, & msgHdr, MSG_NOSIGNAL);
+
+        if (sentLength == -1)
+        {
+           if (errno != EWOULDBLOCK)
+             break;
+
+           sentLength = 0;
+        }
+
+        datagrams [sentCount].dataLength = sentLength;
+    }
+
+    return sentCount > 0 ? (int) sentCount : -1;
+#endif
+}
+
 int
 enet_socket_receive (ENetSocket socket,
                      ENetAddress * address,
@@ -454,6 +686,125 @@ enet_socket_receive (ENetSocket socket,
     return recvLength;
 }
 
+static void
+enet_socket_prepare_receive (struct msghdr * msgHdr,
+                             struct sockaddr_in * sin,
+                             ENetSegmentControl * control,
+                             const ENetDatagram * datagram)
+{
+    memset (msgHdr, 0, sizeof (struct msghdr));
+
+    msgHdr -> msg_name = sin;
+    msgHdr -> msg_namelen = sizeof (struct sockaddr_in);
+    msgHdr -> msg_iov = (struct iovec *) datagram -> buffers;
+    msgHdr -> msg_iovlen = datagram -> bufferCount;
+    msgHdr -> msg_control = control -> data;
+    msgHdr -> msg_controllen = sizeof (control -> data);
+}
+
+static void
+enet_socket_finish_receive (const struct msghdr * msgHdr,
+                            const struct sockaddr_in * sin,
+                            ENetDatagram * datagram,
+                            size_t dataLength)
+{
+#ifdef UDP_GRO
+    struct cmsghdr * cmsg;
+#endif
+
+    datagram -> address.host = (enet_uint32) sin -> sin_addr.s_addr;
+    datagram -> address.port = ENET_NET_TO_HOST_16 (sin -> sin_port);
+    datagram -> dataLength = dataLength;
+    datagram -> segmentSize = 0;
+
+#ifdef HAS_MSGHDR_FLAGS
+    if (msgHdr -> msg_flags & MSG_TRUNC)
+    {
+        datagram -> dataLength = 0;
+        return;
+    }
+#endif
+
+#ifdef UDP_GRO
+    for (cmsg = CMSG_FIRSTHDR (msgHdr); cmsg != NULL; cmsg = CMSG_NXTHDR ((struct msghdr *) msgHdr, cmsg))
+    {
+        if (cmsg -> cmsg_level == IPPROTO_UDP && cmsg -> cmsg_type == UDP_GRO)
+        {
+            int segmentSize;
+
+            memcpy (& segmentSize, CMSG_DATA (cmsg), sizeof (int));
+
+            if (segmentSize > 0 && (size_t) segmentSize < dataLength)
+              datagram -> segmentSize = segmentSize;
+        }
+    }
+#endif
+}
+
+int
+enet_socket_receive_multiple (ENetSocket socket,
+                              ENetDatagram * datagrams,
+                              size_t datagramCount)
+{
+#ifdef HAS_RECVMMSG
+    struct mmsghdr msgHdrs [ENET_DATAGRAM_MAXIMUM];
+    struct sockaddr_in sins [ENET_DATAGRAM_MAXIMUM];
+    ENetSegmentControl controls [ENET_DATAGRAM_MAXIMUM];
+    int recvCount, i;
+
+    if (datagramCount > ENET_DATAGRAM_MAXIMUM)
+      datagramCount = ENET_DATAGRAM_MAXIMUM;
+
+    for (i = 0; i < (int) datagramCount; ++ i)
+    {
+        enet_socket_prepare_receive (& msgHdrs [i].msg_hdr, & sins [i], & controls [i], & datagrams [i]);
+
+        msgHdrs [i].msg_len = 0;
+    }
+
+    recvCount = recvmmsg (socket, msgHdrs, datagramCount, MSG_NOSIGNAL, NULL);
+
+    if (recvCount == -1)
+    {
+       if (errno == EWOULDBLOCK)
+         return 0;
+
+       return -1;
+    }
+
+    for (i = 0; i < recvCount; ++ i)
+      enet_socket_finish_receive (& msgHdrs [i].msg_hdr, & sins [i], & datagrams [i], msgHdrs [i].msg_len);
+
+    return recvCount;
+#else
+    size_t recvCount;
+
+    for (recvCount = 0; recvCount < datagramCount; ++ recvCount)
+    {
+        struct msghdr msgHdr;
+        struct sockaddr_in sin;
+        ENetSegmentControl control;
+        int recvLength;
+
+        enet_socket_prepare_receive (& msgHdr, & sin, & control, & datagrams [recvCount]);
+
+        recvLength = recvmsg (socket, & msgHdr, MSG_NOSIGNAL);
+
+        if (recvLength == -1)
+        {
+           if (errno == EWOULDBLOCK)
+             break;
+
+           return recvCount > 0 ? (int) recvCount : -1;
+        }
+
+        enet_socket_finish_receive (& msgHdr, & sin, & datagrams [recvCount], recvLength);
+    }
+
+    return (int) recvCount;
+#endif
+}
+
 int
 enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocketSet * writeSet, enet_uint32 timeout)
 {
@@ -465,23 +816,64 @@ enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocket
     return select (maxSocket + 1, readSet, writeSet, NULL, & timeVal);
 }
 
+ENetSocket
+enet_socket_create_wakeup (void)
+{
+#ifdef HAS_EVENTFD
+    return eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    return ENET_SOCKET_NULL;
+#endif
+}
+
 int
-enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeout)
+enet_socket_signal_wakeup (ENetSocket wakeup)
+{
+#ifdef HAS_EVENTFD
+    eventfd_t value = 1;
+
+    if (write (wakeup, & value, sizeof (eventfd_t)) < 0 && errno != EAGAIN)
+      return -1;
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+static void
+enet_socket_clear_wakeup (ENetSocket wakeup)
+{
+#ifdef HAS_EVENTFD
+    eventfd_t value;
+
+    if (read (wakeup, & value, sizeof (eventfd_t)) < 0)
+      return;
+#endif
+}
+
+int
+enet_socket_wait_wakeup (ENetSocket socket, ENetSocket wakeup, enet_uint32 * condition, enet_uint32 timeout)
 {
 #ifdef HAS_POLL
-    struct pollfd pollSocket;
+    struct pollfd pollSockets [2];
     int pollCount;
     
-    pollSocket.fd = socket;
-    pollSocket.events = 0;
+    pollSockets [0].fd = socket;
+    pollSockets [0].events = 0;
+    pollSockets [0].revents = 0;
+
+    pollSockets [1].fd = wakeup;
+    pollSockets [1].events = POLLIN;
+    pollSockets [1].revents = 0;
 
     if (* condition & ENET_SOCKET_WAIT_SEND)
-      pollSocket.events |= POLLOUT;
+      pollSockets [0].events |= POLLOUT;
 
     if (* condition & ENET_SOCKET_WAIT_RECEIVE)
-      pollSocket.events |= POLLIN;
+      pollSockets [0].events |= POLLIN;
 
-    pollCount = poll (& pollSocket, 1, timeout);
+    pollCount = poll (pollSockets, wakeup != ENET_SOCKET_NULL ? 2 : 1, timeout);
 
     if (pollCount < 0)
     {
@@ -500,10 +892,13 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
     if (pollCount == 0)
       return 0;
 
-    if (pollSocket.revents & POLLOUT)
+    if (pollSockets [1].revents & POLLIN)
+      enet_socket_clear_wakeup (wakeup);
+
+    if (pollSockets [0].revents & POLLOUT)
       * condition |= ENET_SOCKET_WAIT_SEND;
     
-    if (pollSocket.revents & POLLIN)
+    if (pollSockets [0].revents & POLLIN)
       * condition |= ENET_SOCKET_WAIT_RECEIVE;
 
     return 0;
@@ -524,7 +919,10 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
     if (* condition & ENET_SOCKET_WAIT_RECEIVE)
       FD_SET (socket, & readSet);
 
-    selectCount = select (socket + 1, & readSet, & writeSet, NULL, & timeVal);
+    if (wakeup != ENET_SOCKET_NULL)
+      FD_SET (wakeup, & readSet);
+
+    selectCount = select ((wakeup > socket ? wakeup : socket) + 1, & readSet, & writeSet, NULL, & timeVal);
 
     if (selectCount < 0)
     {
@@ -543,6 +941,9 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
     if (selectCount == 0)
       return 0;
 
+    if (wakeup != ENET_SOCKET_NULL && FD_ISSET (wakeup, & readSet))
+      enet_socket_clear_wakeup (wakeup);
+
     if (FD_ISSET (socket, & writeSet))
       * condition |= ENET_SOCKET_WAIT_SEND;
 
@@ -553,5 +954,129 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
 #endif
 }
 
-#endif
+int
+enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeout)
+{
+    return enet_socket_wait_wakeup (socket, ENET_SOCKET_NULL, condition, timeout);
+}
+
+int
+enet_mutex_create (ENetMutex * mutex)
+{
+    return pthread_mutex_init (mutex, NULL) != 0 ? -1 : 0;
+}
+
+void
+enet_mutex_destroy (ENetMutex * mutex)
+{
+    pthread_mutex_destroy (mutex);
+}
+
+void
+enet_mutex_lock (ENetMutex * mutex)
+{
+    pthread_mutex_lock (mutex);
+}
 
+void
+enet_mutex_unlock (ENetMutex * mutex)
+{
+    pthread_mutex_unlock (mutex);
+}
+
+typedef struct _ENetThreadStart
+{
+    ENetThreadCallback callback;
+    void * context;
+} ENetThreadStart;
+
+static void *
+enet_thread_start (void * start)
+{
+    ENetThreadStart threadStart = * (ENetThreadStart *) start;
+
+    enet_free (start);
+
+    (* threadStart.callback) (threadStart.context);
+
+    return NULL;
+}
+
+int
+enet_thread_create (ENetThread * thread, ENetThreadCallback callback, void * context)
+{
+    ENetThreadStart * start = (ENetThreadStart *) enet_malloc (sizeof (ENetThreadStart));
+
+    if (start == NULL)
+      return -1;
+
+    start -> callback = callback;
+    start -> context = context;
+
+    if (pthread_create (thread, NULL, enet_thread_start, start) != 0)
+    {
+       enet_free (start);
+
+       return -1;
+    }
+
+    return 0;
+}
+
+void
+enet_thread_join (ENetThread * thread)
+{
+    pthread_join (* thread, NULL);
+}
+
+int
+enet_semaphore_create (ENetSemaphore * semaphore)
+{
+    if (pthread_mutex_init (& semaphore -> mutex, NULL) != 0)
+      return -1;
+
+    if (pthread_cond_init (& semaphore -> condition, NULL) != 0)
+    {
+       pthread_mutex_destroy (& semaphore -> mutex);
+
+       return -1;
+    }
+
+    semaphore -> count = 0;
+
+    return 0;
+}
+
+void
+enet_semaphore_destroy (ENetSemaphore * semaphore)
+{
+    pthread_cond_destroy (& semaphore -> condition);
+    pthread_mutex_destroy (& semaphore -> mutex);
+}
+
+void
+enet_semaphore_wait (ENetSemaphore * semaphore)
+{
+    pthread_mutex_lock (& semaphore -> mutex);
+
+    while (semaphore -> count == 0)
+      pthread_cond_wait (& semaphore -> condition, & semaphore -> mutex);
+
+    -- semaphore -> count;
+
+    pthread_mutex_unlock (& semaphore -> mutex);
+}
+
+void
+enet_semaphore_post (ENetSemaphore * semaphore)
+{
+    pthread_mutex_lock (& semaphore -> mutex);
+
+    ++ semaphore -> count;
+
+    pthread_cond_signal (& semaphore -> condition);
+
+    pthread_mutex_unlock (& semaphore -> mutex);
+}
+
+#endif
@@ -326,6 +326,33 @@ enet_socket_send (ENetSocket socket,
     return (int) sentLength;
 }
 
+int
+enet_socket_send_multiple (ENetSocket socket,
+                           ENetDatagram * datagrams,
+                           size_t datagramCount)
+{
+    size_t sentCount;
+
+    for (sentCount = 0; sentCount < datagramCount; ++ sentCount)
+    {
+        int sentLength;
+
+        if (datagrams [sentCount].segmentSize > 0)
+          break;
+
+        sentLength = enet_socket_send (socket,
+                                       & datagrams [sentCount].address,
+                                       datagrams [sentCount].buffers,
+                                       datagrams [sentCount].bufferCount);
+        if (sentLength < 0)
+          break;
+
+        datagrams [sentCount].dataLength = sentLength;
+    }
+
+    return sentCount > 0 ? (int) sentCount : -1;
+}
+
 int
 enet_socket_receive (ENetSocket socket,
                      ENetAddress * address,
@@ -369,6 +396,55 @@ enet_socket_receive (ENetSocket socket,
     return (int) recvLength;
 }
 
+int
+enet_socket_receive_multiple (ENetSocket socket,
+                              ENetDatagram * datagrams,
+                              size_t datagramCount)
+{
+    size_t recvCount;
+
+    for (recvCount = 0; recvCount < datagramCount; ++ recvCount)
+    {
+        ENetDatagram * datagram = & datagrams [recvCount];
+        INT sinLength = sizeof (struct sockaddr_in);
+        DWORD flags = 0,
+              recvLength = 0;
+        struct sockaddr_in sin;
+
+        if (WSARecvFrom (socket,
+                         (LPWSABUF) datagram -> buffers,
+                         (DWORD) datagram -> bufferCount,
+                         & recvLength,
+                         & flags,
+                         (struct sockaddr *) & sin,
+                         & sinLength,
+                         NULL,
+                         NULL) == SOCKET_ERROR)
+        {
+           switch (WSAGetLastError ())
+           {
+           case WSAEWOULDBLOCK:
+           case WSAECONNRESET:
+              return (int) recvCount;
+
+           case WSAEMSGSIZE:
+              flags |= MSG_PARTIAL;
+              break;
+
+           default:
+              return recvCount > 0 ? (int) recvCount : -1;
+           }
+        }
+
+        datagram -> address.host = (enet_uint32) sin.sin_addr.s_addr;
+        datagram -> address.port = ENET_NET_TO_HOST_16 (sin.sin_port);
+        datagram -> dataLength = (flags & MSG_PARTIAL) ? 0 : recvLength;
+        datagram -> segmentSize = 0;
+    }
+
+    return (int) recvCount;
+}
+
 int
 enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocketSet * writeSet, enet_uint32 timeout)
 {
@@ -418,5 +494,122 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
     return 0;
 } 
 
-#endif
+ENetSocket
+enet_socket_create_wakeup (void)
+{
+    return ENET_SOCKET_NULL;
+}
+
+int
+enet_socket_signal_wakeup (ENetSocket wakeup)
+{
+    return -1;
+}
+
+int
+enet_socket_wait_wakeup (ENetSocket socket, ENetSocket wakeup, enet_uint32 * condition, enet_uint32 timeout)
+{
+    return enet_socket_wait (socket, condition, timeout);
+}
+
+int
+enet_mutex_create (ENetMutex * mutex)
+{
+    InitializeCriticalSection (mutex);
+
+    return 0;
+}
+
+void
+enet_mutex_destroy (ENetMutex * mutex)
+{
+    DeleteCriticalSection (mutex);
+}
+
+void
+enet_mutex_lock (ENetMutex * mutex)
+{
+    EnterCriticalSection (mutex);
+}
+
+void
+enet_mutex_unlock (ENetMutex * mutex)
+{
+    LeaveCriticalSection (mutex);
+}
+
+typedef struct _ENetThreadStart
+{
+    ENetThreadCallback callback;
+    void * context;
+} ENetThreadStart;
+
+static DWORD WINAPI
+enet_thread_start (LPVOID start)
+{
+    ENetThreadStart threadStart = * (ENetThreadStart *) start;
 
+    enet_free (start);
+
+    (* threadStart.callback) (threadStart.context);
+
+    return 0;
+}
+
+int
+enet_thread_create (ENetThread * thread, ENetThreadCallback callback, void * context)
+{
+    ENetThreadStart * start = (ENetThreadStart *) enet_malloc (sizeof (ENetThreadStart));
+
+    if (start == NULL)
+      return -1;
+
+    start -> callback = callback;
+    start -> context = context;
+
+    * thread = CreateThread (NULL, 0, enet_thread_start, start, 0, NULL);
+    if (* thread == NULL)
+    {
+       enet_free (start);
+
+       return -1;
+    }
+
+    return 0;
+}
+
+void
+enet_thread_join (ENetThread * thread)
+{
+    WaitForSingleObject (* thread, INFINITE);
+
+    CloseHandle (* thread);
+}
+
+int
+enet_semaphore_create (ENetSemaphore * semaphore)
+{
+    * semaphore = CreateSemaphore (NULL, 0, 0x7FFFFFFF, NULL);
+
+    return * semaphore != NULL ? 0 : -1;
+}
+
+void
+enet_semaphore_destroy (ENetSemaphore * semaphore)
+{
+    CloseHandle (* semaphore);
+}
+
+void
+enet_semaphore_wait (ENetSemaphore * semaphore)
+{
+    WaitForSingleObject (* semaphore, INFINITE);
+}
+
+void
+enet_semaphore_post (ENetSemaphore * semaphore)
+{
+    ReleaseSemaphore (* semaphore, 1, NULL);
+}
+
+#endif